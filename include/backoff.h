@@ -0,0 +1,30 @@
+#pragma once
+
+#include "common.h"
+
+#include <algorithm>
+
+// Backoff policies for lock-free CAS retry loops.
+//
+// A failed CAS means another thread just won the line; retrying
+// immediately only prolongs the invalidation storm. Policies are
+// stateless types consulted via on_cas_fail(attempt) after each failed
+// attempt, so the containers can be instantiated with or without
+// backoff and the untaken branch costs nothing.
+
+// Retry immediately. Useful as a baseline and for low-contention uses.
+struct NoBackoff {
+    static void on_cas_fail(int /*attempt*/) {}
+};
+
+// Ethernet-style truncated exponential backoff: 1, 2, 4, ... up to 256
+// PAUSEs. Caps well below a timeslice so a backed-off thread never
+// looks idle to the scheduler.
+struct ExpBackoff {
+    static void on_cas_fail(int attempt)
+    {
+        int spins = 1 << std::min(attempt, 8);
+        for (int i = 0; i < spins; ++i)
+            cpu_relax();
+    }
+};
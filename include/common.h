@@ -2,6 +2,7 @@
 #include <optional>
 
 #include <atomic>
+#include <barrier>
 #include <cassert>
 #include <chrono>
 #include <cstddef>
@@ -23,6 +24,118 @@
 #include <mutex>
 #include <condition_variable>
 
+// Spin-wait hint: PAUSE on x86, YIELD on arm64, scheduler yield elsewhere
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// One atomic per 64-byte cache line, so logically independent atomics
+// (e.g. a queue's head and tail) stop invalidating each other's lines.
+template <typename T>
+struct alignas(64) Padded {
+    std::atomic<T> v{};
+
+    Padded() = default;
+    explicit Padded(T initial) : v{initial} {}
+};
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Pin a worker to a fixed CPU so the scheduler cannot migrate it
+// mid-measurement: migrations collapse threads onto shared caches and
+// make contention depend on scheduler mood rather than the container.
+// Wraps around when asked for more cores than exist; no-op off Linux or
+// on a single-core host.
+inline void set_affinity(std::jthread& th, int core)
+{
+#ifdef __linux__
+    unsigned n = std::thread::hardware_concurrency();
+    if (n <= 1)
+        return;  // nothing to separate
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(static_cast<unsigned>(core) % n, &set);
+    pthread_setaffinity_np(th.native_handle(), sizeof(set), &set);
+#else
+    (void)th;
+    (void)core;
+#endif
+}
+
+// Reusable worker pool.
+//
+// The bench sweep and the multi-section tests each run their workload
+// many times; spawning fresh kernel threads per run costs tens of
+// microseconds each. The pool spawns max_threads pinned workers once;
+// each run hands them a job through a pair of barriers, which doubles
+// as a synchronized start.
+class WorkerPool {
+public:
+    explicit WorkerPool(int max_threads)
+        : start_(max_threads + 1), done_(max_threads + 1)
+    {
+        ws_.reserve(max_threads);
+        for (int i = 0; i < max_threads; ++i) {
+            ws_.emplace_back([this, i] { loop(i); });
+            set_affinity(ws_.back(), i);
+        }
+    }
+
+    ~WorkerPool()
+    {
+        stop_.store(true, std::memory_order_release);
+        start_.arrive_and_wait();  // wake workers so they can exit
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int size() const { return static_cast<int>(ws_.size()); }
+
+    // Run job(0..n-1) on the first n workers and wait for all of them.
+    void run(int n, const std::function<void(int)>& job)
+    {
+        n_   = n;
+        job_ = &job;
+        start_.arrive_and_wait();
+        done_.arrive_and_wait();
+    }
+
+private:
+    void loop(int id)
+    {
+        for (;;) {
+            start_.arrive_and_wait();
+            if (stop_.load(std::memory_order_acquire))
+                return;
+            if (id < n_)
+                (*job_)(id);
+            done_.arrive_and_wait();
+        }
+    }
+
+    std::barrier<>                    start_;
+    std::barrier<>                    done_;
+    const std::function<void(int)>*   job_{nullptr};
+    int                               n_{0};
+    std::atomic<bool>                 stop_{false};
+    // Declared last so the jthreads are joined first: main returning
+    // from the destructor's arrive_and_wait() does not mean a worker
+    // has left the barrier call yet, and the barriers must not be
+    // destroyed under it.
+    std::vector<std::jthread>         ws_;
+};
+
 // ==== include ALL data structures here ====
 
 #include "sgl_stack.h"
@@ -42,8 +155,9 @@ inline std::uint64_t now_ns()
         .count();
 }
 
-// Simple assert helper
-inline void check(bool cond, const char* msg)
+// Simple assert helper. Forced inline so only the one-branch fast path
+// lands in the caller's hot loop; the abort path stays cold.
+__attribute__((always_inline)) inline void check(bool cond, const char* msg)
 {
     if (!cond) {
         std::cerr << "CHECK FAILED: " << msg << std::endl;
@@ -51,6 +165,19 @@ inline void check(bool cond, const char* msg)
     }
 }
 
+// Lazy variant for hot verification loops: msg_fn is only invoked — and
+// its string only allocated — on failure, instead of concatenating a
+// fresh std::string per iteration just to throw it away.
+template <typename MsgFn>
+    requires requires(MsgFn f) { std::string(f()); }
+__attribute__((always_inline)) inline void check(bool cond, MsgFn&& msg_fn)
+{
+    if (!cond) {
+        std::cerr << "CHECK FAILED: " << std::string(msg_fn()) << std::endl;
+        std::abort();
+    }
+}
+
 // Random generator per thread
 inline std::mt19937& thread_rng()
 {
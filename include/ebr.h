@@ -0,0 +1,182 @@
+#pragma once
+
+#include "common.h"
+#include <array>
+
+// Epoch-based reclamation (EBR).
+//
+// A thread "pins" the current global epoch while it works on a lock-free
+// structure and unpins on exit. Retired nodes go into one of three limbo
+// bags keyed by retire epoch; a bag may be freed once the global epoch
+// has advanced twice past it, because the epoch can only advance when no
+// thread is still pinned to an older one. Entering/leaving a critical
+// section is two plain stores — no per-pointer publication and no
+// O(retired x hazard-slots) scan as with hazard pointers.
+
+namespace ebr {
+
+// Maximum number of threads that can simultaneously be in a critical section
+inline constexpr std::size_t MAX_THREADS = 64;
+
+// Sentinel meaning "not in a critical section"
+inline constexpr std::uint64_t IDLE = ~std::uint64_t{0};
+
+inline std::atomic<std::uint64_t> g_epoch{0};
+
+// Per-thread epoch slot, one per cache line
+struct alignas(64) LocalEpoch {
+    std::atomic<std::uint64_t> active{IDLE};
+    std::atomic<bool>          in_use{false};
+};
+
+inline LocalEpoch g_local_epochs[MAX_THREADS];
+
+inline LocalEpoch* acquire_local_epoch()
+{
+    for (auto& le : g_local_epochs) {
+        bool expected = false;
+        if (le.in_use.compare_exchange_strong(
+                expected, true, std::memory_order_acq_rel)) {
+            return &le;
+        }
+    }
+
+    std::cerr << "No free EBR epoch slots available\n";
+    std::abort();
+}
+
+// Claims a slot on first use and hands it back on thread exit
+class LocalEpochOwner {
+public:
+    LocalEpochOwner() : le_(acquire_local_epoch()) {}
+
+    ~LocalEpochOwner()
+    {
+        le_->active.store(IDLE, std::memory_order_release);
+        le_->in_use.store(false, std::memory_order_release);
+    }
+
+    LocalEpochOwner(const LocalEpochOwner&) = delete;
+    LocalEpochOwner& operator=(const LocalEpochOwner&) = delete;
+
+    LocalEpoch& get() { return *le_; }
+
+private:
+    LocalEpoch* le_;
+};
+
+inline LocalEpoch& local_epoch()
+{
+    thread_local LocalEpochOwner owner;
+    return owner.get();
+}
+
+// RAII critical-section guard. Not reentrant: one live Guard per thread.
+class Guard {
+public:
+    Guard() : le_(&local_epoch())
+    {
+        le_->active.store(g_epoch.load(std::memory_order_relaxed),
+                          std::memory_order_relaxed);
+        // The epoch must be visibly pinned before we load any pointers
+        // out of the protected structure.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    ~Guard()
+    {
+        le_->active.store(IDLE, std::memory_order_release);
+    }
+
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+
+private:
+    LocalEpoch* le_;
+};
+
+// Try to move the global epoch forward. Fails if any thread is still
+// pinned to an older epoch.
+inline bool try_advance()
+{
+    std::uint64_t e = g_epoch.load(std::memory_order_acquire);
+    for (auto& le : g_local_epochs) {
+        std::uint64_t a = le.active.load(std::memory_order_acquire);
+        if (a != IDLE && a != e)
+            return false;
+    }
+    return g_epoch.compare_exchange_strong(
+        e, e + 1, std::memory_order_acq_rel);
+}
+
+// Per-thread limbo bags and reclamation logic. The deleter is a
+// compile-time parameter so pooled allocators can recycle instead of
+// delete.
+template <typename T, class D = std::default_delete<T>>
+class RetireList {
+public:
+    void retire(T* node)
+    {
+        std::uint64_t e = g_epoch.load(std::memory_order_acquire);
+        Bag& b = bags_[e % 3];
+
+        // The bag indexed e%3 can only hold garbage from epoch e-3 or
+        // earlier, which is already past its grace period.
+        if (!b.items.empty() && b.epoch != e)
+            free_bag(b);
+
+        b.epoch = e;
+        b.items.push_back(node);
+
+        if (++since_scan_ >= scan_interval_) {
+            since_scan_ = 0;
+            try_advance();
+            reclaim_expired();
+        }
+    }
+
+    // Force reclaim (e.g., when the caller knows no readers remain)
+    void force_reclaim()
+    {
+        for (Bag& b : bags_)
+            free_bag(b);
+    }
+
+private:
+    struct Bag {
+        std::vector<T*> items;
+        std::uint64_t   epoch = 0;
+    };
+
+    void free_bag(Bag& b)
+    {
+        for (T* p : b.items)
+            deleter_(p);
+        b.items.clear();
+    }
+
+    void reclaim_expired()
+    {
+        std::uint64_t cur = g_epoch.load(std::memory_order_acquire);
+        for (Bag& b : bags_) {
+            // Two whole epochs have passed: no reader can still hold it
+            if (!b.items.empty() && b.epoch + 2 <= cur)
+                free_bag(b);
+        }
+    }
+
+    std::array<Bag, 3>      bags_;
+    [[no_unique_address]] D deleter_{};
+    std::size_t             since_scan_    = 0;
+    std::size_t             scan_interval_ = 64; // tune if needed
+};
+
+// Get per-thread retire list
+template <typename T, class D = std::default_delete<T>>
+inline RetireList<T, D>& retire_list()
+{
+    thread_local RetireList<T, D> rl{};
+    return rl;
+}
+
+} // namespace ebr
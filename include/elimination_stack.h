@@ -1,9 +1,9 @@
 #pragma once
 
 #include "common.h"
+#include "node_pool.h"
 #include <atomic>
 #include <array>
-#include <random>
 #include <thread>
 
 // A Treiber stack with an elimination array.
@@ -12,13 +12,14 @@
 //   "eliminate" with an opposing pop/push in the arena.
 
 template <typename T>
-class EliminationStack {
+class alignas(64) EliminationStack {
 private:
     // ---------------- Central Treiber stack ----------------
     struct Node {
         T     value;
         Node* next;
         explicit Node(const T& v) : value(v), next(nullptr) {}
+        explicit Node(T&& v) : value(std::move(v)), next(nullptr) {}
     };
 
     std::atomic<Node*> head_{nullptr};
@@ -27,18 +28,63 @@ private:
     static constexpr int ELIM_ARRAY_SIZE  = 16;
     static constexpr int ELIM_TRIES       = 4;   // how many slots to try
     static constexpr int CAS_THRESHOLD    = 4;   // after this many CAS failures, try elimination
-    static constexpr int SPIN_ITERS       = 10;  // how long to wait for a match
+    static constexpr int SPIN_ITERS       = 10;  // backoff rounds waiting for a match
+    static constexpr int BACKOFF_MIN      = 8;   // pause cycles, first round
+    static constexpr int BACKOFF_MAX      = 1024; // pause cycles, cap
 
     // Each slot either holds nullptr or a Node* offered by a pusher.
-    std::array<std::atomic<Node*>, ELIM_ARRAY_SIZE> arena_;
+    // One slot per cache line: independent CAS attempts on different
+    // slots must not ping-pong the same line.
+    std::array<Padded<Node*>, ELIM_ARRAY_SIZE> arena_;
 
-    // Thread-local RNG for picking slots
-    static thread_local std::mt19937 rng_;
+    static_assert((ELIM_ARRAY_SIZE & (ELIM_ARRAY_SIZE - 1)) == 0,
+                  "slot mask requires a power-of-two arena");
 
-    static int random_slot()
+    // Slot selection is sharded by thread instead of randomized: a
+    // pusher always starts at a slot derived from its own id, so its
+    // offer sits in a stable place across retries, while pops sweep
+    // the arena with a shared rotating counter and therefore find any
+    // waiting offer within one lap. Random picking needed both sides
+    // to collide by luck, which decays quadratically with arena size.
+    static std::uint32_t thread_tid()
     {
-        std::uniform_int_distribution<int> dist(0, ELIM_ARRAY_SIZE - 1);
-        return dist(rng_);
+        thread_local std::uint32_t tid = static_cast<std::uint32_t>(
+            std::hash<std::thread::id>{}(std::this_thread::get_id()));
+        return tid;
+    }
+
+    // Rotating pop index, on its own cache line so the fetch_add does
+    // not drag the arena slots around with it.
+    Padded<std::uint32_t> pop_ctr_;
+
+    // ---------------- Adaptive elimination gate ----------------
+    // On a push-only (or pop-only) workload the arena can never match,
+    // so every escalation is a CAS-in, a spin and a CAS-out for zero
+    // benefit. Track a per-thread hit rate over windows of 1024
+    // attempts and fall back to plain exponential backoff when the
+    // rate drops below ~1/128; re-probe periodically so a workload
+    // shift turns the arena back on.
+    static thread_local std::uint32_t elim_attempts_;
+    static thread_local std::uint32_t elim_hits_;
+    static thread_local bool          elim_enabled_;
+    static thread_local std::uint32_t elim_reprobe_tick_;
+
+    static void update_elim_gate()
+    {
+        if (elim_attempts_ >= 1024) {
+            elim_enabled_ = (elim_hits_ * 128 > elim_attempts_);
+            // Decay instead of reset so a mode shift shows up quickly
+            elim_attempts_ >>= 1;
+            elim_hits_ >>= 1;
+        }
+    }
+
+    static bool elim_allowed()
+    {
+        if (elim_enabled_)
+            return true;
+        // Disabled: probe the arena again every 1024 escalations
+        return (++elim_reprobe_tick_ & 1023) == 0;
     }
 
     // Try to match this push with a pop in the arena.
@@ -47,29 +93,38 @@ private:
     bool try_elim_push(Node*& n)
     {
         for (int attempt = 0; attempt < ELIM_TRIES; ++attempt) {
-            int   idx      = random_slot();
+            int   idx      = static_cast<int>(
+                (thread_tid() + static_cast<std::uint32_t>(attempt)) &
+                (ELIM_ARRAY_SIZE - 1));
             Node* expected = nullptr;
 
             // Offer our node into an empty slot
-            if (arena_[idx].compare_exchange_strong(
+            if (arena_[idx].v.compare_exchange_strong(
                     expected, n,
                     std::memory_order_acq_rel,
                     std::memory_order_relaxed)) {
 
-                // Wait briefly for a pop to take it
+                // Wait briefly for a pop to take it. Exponential PAUSE
+                // backoff: yield() is a syscall and costs ~1-2 us, far
+                // more than the window we are waiting out, so escalate
+                // to it only once the pause budget is exhausted.
+                int budget = BACKOFF_MIN;
                 for (int i = 0; i < SPIN_ITERS; ++i) {
-                    Node* cur = arena_[idx].load(std::memory_order_acquire);
+                    for (int j = 0; j < budget; ++j)
+                        cpu_relax();
+                    Node* cur = arena_[idx].v.load(std::memory_order_acquire);
                     if (cur != n) {
                         // Someone took it (slot changed or cleared)
                         n = nullptr;  // pop now owns and will delete
                         return true;
                     }
-                    std::this_thread::yield();
+                    budget = std::min(budget * 2, BACKOFF_MAX);
                 }
+                std::this_thread::yield();
 
                 // Timed out; try to reclaim the slot
                 Node* cur = n;
-                if (arena_[idx].compare_exchange_strong(
+                if (arena_[idx].v.compare_exchange_strong(
                         cur, nullptr,
                         std::memory_order_acq_rel,
                         std::memory_order_relaxed)) {
@@ -88,14 +143,22 @@ private:
     // Try to satisfy a pop from the arena instead of the central stack.
     bool try_elim_pop(T& out)
     {
+        int budget = BACKOFF_MIN;
         for (int attempt = 0; attempt < ELIM_TRIES; ++attempt) {
-            int   idx = random_slot();
-            Node* n   = arena_[idx].exchange(nullptr, std::memory_order_acq_rel);
+            int   idx = static_cast<int>(
+                pop_ctr_.v.fetch_add(1, std::memory_order_relaxed) &
+                (ELIM_ARRAY_SIZE - 1));
+            Node* n   = arena_[idx].v.exchange(nullptr, std::memory_order_acq_rel);
             if (n != nullptr) {
-                out = n->value;
-                delete n;
+                out = std::move(n->value);
+                NodePool<Node>::free(n);
                 return true;
             }
+            // Empty slot: back off a little before probing the next one
+            // so a pusher has time to land an offer.
+            for (int j = 0; j < budget; ++j)
+                cpu_relax();
+            budget = std::min(budget * 2, BACKOFF_MAX);
         }
         return false;
     }
@@ -104,7 +167,7 @@ public:
     EliminationStack()
     {
         for (auto& slot : arena_) {
-            slot.store(nullptr, std::memory_order_relaxed);
+            slot.v.store(nullptr, std::memory_order_relaxed);
         }
     }
 
@@ -114,15 +177,15 @@ public:
         Node* n = head_.load(std::memory_order_relaxed);
         while (n) {
             Node* next = n->next;
-            delete n;
+            NodePool<Node>::free(n);
             n = next;
         }
         // Drain any leftover nodes in arena (best-effort)
         for (auto& slot : arena_) {
-            Node* p = slot.exchange(nullptr, std::memory_order_relaxed);
+            Node* p = slot.v.exchange(nullptr, std::memory_order_relaxed);
             while (p) {
                 Node* next = p->next;
-                delete p;
+                NodePool<Node>::free(p);
                 p = next;
             }
         }
@@ -133,17 +196,23 @@ public:
         if (head_.load(std::memory_order_acquire) != nullptr)
             return false;
         for (auto& slot : arena_) {
-            if (slot.load(std::memory_order_acquire) != nullptr)
+            if (slot.v.load(std::memory_order_acquire) != nullptr)
                 return false;
         }
         return true;
     }
 
     // ---------------- push with Treiber + elimination ----------------
-    void push(const T& v)
+    void push(const T& v) { push_impl(v); }
+    void push(T&& v) { push_impl(std::move(v)); }
+
+private:
+    template <typename U>
+    void push_impl(U&& v)
     {
-        Node* n = new Node(v);
+        Node* n = NodePool<Node>::alloc(std::forward<U>(v));
         int   cas_failures = 0;
+        int   backoff      = BACKOFF_MIN;
 
         while (true) {
             Node* old_head = head_.load(std::memory_order_relaxed);
@@ -159,19 +228,34 @@ public:
 
             // CAS failed: possible contention
             if (++cas_failures >= CAS_THRESHOLD) {
-                if (try_elim_push(n)) {
-                    // Eliminated with a pop; node consumed
-                    return;
+                if (elim_allowed()) {
+                    ++elim_attempts_;
+                    bool hit = try_elim_push(n);
+                    if (hit)
+                        ++elim_hits_;
+                    update_elim_gate();
+                    if (hit) {
+                        // Eliminated with a pop; node consumed
+                        return;
+                    }
+                } else {
+                    // Arena is not matching on this workload: back off
+                    // like a classic Treiber stack instead.
+                    for (int j = 0; j < backoff; ++j)
+                        cpu_relax();
+                    backoff = std::min(backoff * 2, BACKOFF_MAX);
                 }
                 cas_failures = 0; // try CAS again
             }
         }
     }
 
+public:
     // ---------------- pop with Treiber + elimination ----------------
     bool pop(T& out)
     {
         int cas_failures = 0;
+        int backoff      = BACKOFF_MIN;
 
         while (true) {
             Node* old_head = head_.load(std::memory_order_acquire);
@@ -190,21 +274,38 @@ public:
                     std::memory_order_acq_rel,
                     std::memory_order_acquire)) {
                 // Treiber pop succeeded
-                out = old_head->value;
-                delete old_head;
+                out = std::move(old_head->value);
+                NodePool<Node>::free(old_head);
                 return true;
             }
 
             // CAS failed: possible contention
             if (++cas_failures >= CAS_THRESHOLD) {
-                if (try_elim_pop(out))
-                    return true;
+                if (elim_allowed()) {
+                    ++elim_attempts_;
+                    bool hit = try_elim_pop(out);
+                    if (hit)
+                        ++elim_hits_;
+                    update_elim_gate();
+                    if (hit)
+                        return true;
+                } else {
+                    for (int j = 0; j < backoff; ++j)
+                        cpu_relax();
+                    backoff = std::min(backoff * 2, BACKOFF_MAX);
+                }
                 cas_failures = 0;
             }
         }
     }
 };
 
-// Define the thread-local RNG
+// Adaptive-gate thread-local state (arena starts enabled)
+template <typename T>
+thread_local std::uint32_t EliminationStack<T>::elim_attempts_ = 0;
+template <typename T>
+thread_local std::uint32_t EliminationStack<T>::elim_hits_ = 0;
+template <typename T>
+thread_local bool EliminationStack<T>::elim_enabled_ = true;
 template <typename T>
-thread_local std::mt19937 EliminationStack<T>::rng_{std::random_device{}()};
+thread_local std::uint32_t EliminationStack<T>::elim_reprobe_tick_ = 0;
@@ -1,95 +1,363 @@
 #pragma once
 
 #include "common.h"
-#include <deque>
-#include <list>
-#include <mutex>
 #include <atomic>
+#include <memory>
+#include <cstring>
+#include <type_traits>
 
 template <typename T>
 class FlatCombiningQueue {
 public:
     FlatCombiningQueue() = default;
 
-    bool empty()
+    // Lock-free size hint, refreshed by the combiner once per drain.
+    // It was always only a momentary observation; now reading it no
+    // longer stalls behind an active combiner.
+    bool empty() const
     {
-        std::lock_guard<std::mutex> lk(combine_m_);
-        return data_.empty();
+        return size_hint_.load(std::memory_order_acquire) == 0;
     }
 
-    void enqueue(const T& v)
+    void enqueue(const T& v) { enqueue_impl(v); }
+    void enqueue(T&& v) { enqueue_impl(std::move(v)); }
+
+    bool dequeue(T& out)
     {
         Request& r = get_request();
-        r.value    = v;
-        r.success  = true;  // enqueue always succeeds
-        r.op.store(Request::Op::ENQ, std::memory_order_release);
+        r.state.store(pack(OP_DEQ, false), std::memory_order_release);
 
-        combine();
-        // after combine(), enqueue is done
+        std::uint32_t st = wait_or_combine(r);
+        // the acquire load that saw OP_NONE also orders value/success
+        if (st & SUCCESS_BIT)
+            out = std::move(r.value);
+        return (st & SUCCESS_BIT) != 0;
     }
 
-    bool dequeue(T& out)
+    // Enqueue n values in one combining round: callers that already
+    // hold a batch skip n-1 publish/wait round trips.
+    void bulk_enqueue(const T* first, std::size_t n)
+    {
+        if (n == 0)
+            return;
+        Request& r = get_request();
+        r.in = first;
+        r.n  = n;
+        r.state.store(pack(OP_ENQ_N, true), std::memory_order_release);
+
+        wait_or_combine(r);
+    }
+
+    // Dequeue up to max_n values into out; returns how many were
+    // actually dequeued (0 if the queue was empty).
+    std::size_t bulk_dequeue(T* out, std::size_t max_n)
     {
+        if (max_n == 0)
+            return 0;
         Request& r = get_request();
-        r.success  = false;
-        r.op.store(Request::Op::DEQ, std::memory_order_release);
-
-        combine();
-        // after combine(), success/value are stable
-        if (r.success)
-            out = r.value;
-        return r.success;
+        r.out = out;
+        r.n   = max_n;
+        r.state.store(pack(OP_DEQ_N, false), std::memory_order_release);
+
+        wait_or_combine(r);
+        // n_done is ordered by the acquire load of OP_NONE
+        return r.n_done;
     }
 
 private:
-    struct Request {
-        enum class Op { NONE, ENQ, DEQ };
-        std::atomic<Op> op{Op::NONE};
-        T               value{};
-        bool            success{false};
+    template <typename U>
+    void enqueue_impl(U&& v)
+    {
+        Request& r = get_request();
+        r.value    = std::forward<U>(v);
+        r.state.store(pack(OP_ENQ, true), std::memory_order_release);
+
+        wait_or_combine(r);
+        // our request has been processed (enqueue always succeeds)
+    }
+
+    // Copy [src, src+n) into the ring at tail_; for trivially copyable
+    // T this is at most two memcpy spans around the wrap point.
+    void ring_append(const T* src, std::size_t n)
+    {
+        if ((tail_ - head_) + n > cap_)
+            grow_ring((tail_ - head_) + n);
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            std::size_t pos   = tail_ & (cap_ - 1);
+            std::size_t first = std::min(n, cap_ - pos);
+            std::memcpy(&ring_[pos], src, first * sizeof(T));
+            std::memcpy(&ring_[0], src + first, (n - first) * sizeof(T));
+        } else {
+            for (std::size_t i = 0; i < n; ++i)
+                ring_[(tail_ + i) & (cap_ - 1)] = src[i];
+        }
+        tail_ += n;
+    }
+
+    // Move [head_, head_+n) out of the ring into dst; memcpy spans for
+    // trivially copyable T, element moves otherwise.
+    void ring_consume(T* dst, std::size_t n)
+    {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            std::size_t pos   = head_ & (cap_ - 1);
+            std::size_t first = std::min(n, cap_ - pos);
+            std::memcpy(dst, &ring_[pos], first * sizeof(T));
+            std::memcpy(dst + first, &ring_[0], (n - first) * sizeof(T));
+        } else {
+            for (std::size_t i = 0; i < n; ++i)
+                dst[i] = std::move(ring_[(head_ + i) & (cap_ - 1)]);
+        }
+        head_ += n;
+    }
+
+    // Op and success flag packed into one atomic word: the combiner
+    // finishes a request with a single release store, and the waiter's
+    // acquire load of OP_NONE orders the success bit and value with it
+    // (a separate plain `success` member had no such ordering on the
+    // lock-free path).
+    static constexpr std::uint32_t OP_NONE     = 0;
+    static constexpr std::uint32_t OP_ENQ      = 1;
+    static constexpr std::uint32_t OP_DEQ      = 2;
+    static constexpr std::uint32_t OP_ENQ_N    = 3;
+    static constexpr std::uint32_t OP_DEQ_N    = 4;
+    static constexpr std::uint32_t OP_MASK     = 0x7;
+    static constexpr std::uint32_t SUCCESS_BIT = 0x8;
+
+    static constexpr std::uint32_t pack(std::uint32_t op, bool success)
+    {
+        return op | (success ? SUCCESS_BIT : 0);
+    }
+
+    struct alignas(64) Request {
+        std::atomic<std::uint32_t> state{OP_NONE};
+        T                          value{};
+        Request*                   pub_next{nullptr};  // intrusive publication link
+        // Bulk-op fields: caller-owned buffers, valid until completion
+        const T*                   in{nullptr};
+        T*                         out{nullptr};
+        std::size_t                n{0};
+        std::size_t                n_done{0};
     };
 
-    std::mutex          combine_m_;
-    std::deque<T>       data_;
-    std::list<Request*> requests_;
-    thread_local static Request* tls_req_;
+    // Publication list (Hendler/Incze/Shavit style): threads publish
+    // request records lock-free; whoever wins combiner_active_ drains
+    // every pending record, so the fast path is one CAS, no mutex.
+    std::atomic<bool>     combiner_active_{false};
+    std::atomic<Request*> pub_head_{nullptr};
+
+    // Contiguous power-of-two ring; only touched while holding the
+    // combiner role, so no atomics. head_/tail_ grow monotonically and
+    // are masked on access, which replaces std::deque's chunked map
+    // indirection with straight-line stores and loads.
+    std::unique_ptr<T[]> ring_{new T[INITIAL_CAP]};
+    std::size_t          cap_{INITIAL_CAP};
+    std::size_t          head_{0};
+    std::size_t          tail_{0};
+
+    // Published copy of tail_-head_ for lock-free empty()
+    std::atomic<std::size_t> size_hint_{0};
+
+    static constexpr std::size_t INITIAL_CAP = 4096;
+
+    // Requests drained per combining round; bounds the stack scratch
+    // space and keeps any one round short under heavy load.
+    static constexpr std::size_t COMBINE_BATCH = 32;
+
+    void grow_ring(std::size_t need)
+    {
+        std::size_t new_cap = cap_;
+        while (new_cap < need)
+            new_cap *= 2;
+        std::unique_ptr<T[]> nr{new T[new_cap]};
+        std::size_t          n = tail_ - head_;
+        for (std::size_t i = 0; i < n; ++i)
+            nr[i] = std::move(ring_[(head_ + i) & (cap_ - 1)]);
+        ring_ = std::move(nr);
+        cap_  = new_cap;
+        head_ = 0;
+        tail_ = n;
+    }
+
+    // One record per (thread, instance). Records are never freed: they
+    // stay on the publication list for the life of the container (tiny
+    // bounded leak, same policy as before). Instances are identified by
+    // a monotonic id rather than `this`, because a new queue can be
+    // allocated at the address of a destroyed one.
+    inline static std::atomic<std::uint64_t> next_instance_id_{1};
+    const std::uint64_t instance_id_{
+        next_instance_id_.fetch_add(1, std::memory_order_relaxed)};
+
+    struct TlsSlot {
+        std::uint64_t owner;
+        Request*      req;
+    };
+    thread_local static TlsSlot tls_req_;
 
     Request& get_request()
     {
-        if (!tls_req_) {
+        // Re-key when this thread first touches this instance, so a
+        // record from a previous (possibly destroyed) queue is never
+        // reused against the wrong publication list.
+        if (tls_req_.owner != instance_id_) {
             auto* r = new Request();  // intentionally never freed
-            {
-                std::lock_guard<std::mutex> lk(combine_m_);
-                requests_.push_back(r);
+            Request* head = pub_head_.load(std::memory_order_relaxed);
+            do {
+                r->pub_next = head;
+            } while (!pub_head_.compare_exchange_weak(
+                head, r,
+                std::memory_order_release,
+                std::memory_order_relaxed));
+            tls_req_ = {instance_id_, r};
+        }
+        return *tls_req_.req;
+    }
+
+    // Either become the combiner and drain everything (including our own
+    // request, which is already published), or spin until some other
+    // combiner completes our request for us.
+    std::uint32_t wait_or_combine(Request& r)
+    {
+        while (true) {
+            if (!combiner_active_.exchange(true, std::memory_order_acq_rel)) {
+                combine();
+                combiner_active_.store(false, std::memory_order_release);
+                // our record was on the list before the drain
+                return r.state.load(std::memory_order_relaxed);
+            }
+
+            // Lost the election: wait briefly on our own record, then
+            // go try to become the combiner again.
+            for (int i = 0; i < 64; ++i) {
+                std::uint32_t st = r.state.load(std::memory_order_acquire);
+                if ((st & OP_MASK) == OP_NONE)
+                    return st;
+                cpu_relax();
             }
-            tls_req_ = r;
         }
-        return *tls_req_;
     }
 
+    // Runs only while we hold combiner_active_, so the ring needs no lock.
+    // Requests are drained in bounded batches: each round snapshots up
+    // to COMBINE_BATCH ready records into a contiguous stack array, so
+    // the serving passes run over plain pointers instead of re-chasing
+    // the publication list.
     void combine()
     {
-        std::lock_guard<std::mutex> lk(combine_m_);
-        for (Request* r : requests_) {
-            auto op = r->op.load(std::memory_order_acquire);
-            if (op == Request::Op::ENQ) {
-                data_.push_back(r->value);
-                // success already true
-                r->op.store(Request::Op::NONE, std::memory_order_release);
-            } else if (op == Request::Op::DEQ) {
-                if (!data_.empty()) {
-                    r->value   = data_.front();
-                    data_.pop_front();
-                    r->success = true;
-                } else {
-                    r->success = false;
-                }
-                r->op.store(Request::Op::NONE, std::memory_order_release);
+        while (true) {
+            Request*    ready[COMBINE_BATCH];
+            std::size_t nr = 0;
+            for (Request* r = pub_head_.load(std::memory_order_acquire);
+                 r != nullptr && nr < COMBINE_BATCH;
+                 r = r->pub_next) {
+                __builtin_prefetch(r->pub_next);
+                if ((r->state.load(std::memory_order_acquire) & OP_MASK) !=
+                    OP_NONE)
+                    ready[nr++] = r;
+            }
+            if (nr == 0)
+                break;
+
+            // Dispatch on batch size: a compile-time bound on the
+            // scratch arrays lets the compiler unroll the small cases.
+            if (nr <= 4)
+                drain<4>(ready, nr);
+            else if (nr <= 16)
+                drain<16>(ready, nr);
+            else
+                drain<COMBINE_BATCH>(ready, nr);
+
+            // A short batch means the walk saw every ready record.
+            if (nr < COMBINE_BATCH)
+                break;
+        }
+
+        size_hint_.store(tail_ - head_, std::memory_order_release);
+    }
+
+    template <std::size_t N>
+    void drain(Request* const* ready, std::size_t nr)
+    {
+        Request*    enqs[N];
+        Request*    deqs[N];
+        Request*    bulk_deqs[N];
+        std::size_t ne = 0;
+        std::size_t nd = 0;
+        std::size_t nb = 0;
+        for (std::size_t i = 0; i < nr; ++i) {
+            Request*      r = ready[i];
+            std::uint32_t op =
+                r->state.load(std::memory_order_relaxed) & OP_MASK;
+            if (op == OP_ENQ) {
+                enqs[ne++] = r;
+            } else if (op == OP_DEQ) {
+                deqs[nd++] = r;
+            } else if (op == OP_ENQ_N) {
+                // Apply bulk enqueues immediately: one capacity check,
+                // then straight-line stores (memcpy for trivial T).
+                ring_append(r->in, r->n);
+                r->state.store(pack(OP_NONE, true),
+                               std::memory_order_release);
+            } else if (op == OP_DEQ_N) {
+                // Defer bulk dequeues to the end of the round so they
+                // also see this round's enqueues.
+                bulk_deqs[nb++] = r;
             }
         }
+
+        // Serve dequeues from the shared ring first, in FIFO order;
+        // consuming is just an advance of head_.
+        std::size_t served = std::min(nd, tail_ - head_);
+        for (std::size_t i = 0; i < served; ++i) {
+            deqs[i]->value = std::move(ring_[head_ & (cap_ - 1)]);
+            ++head_;
+        }
+
+        // Once the queue is drained, pair leftover dequeues with
+        // pending enqueues peer-to-peer. Pairing is only FIFO-correct
+        // on an empty queue, which is guaranteed here; the ring is
+        // untouched.
+        std::size_t ei = 0;
+        while (served < nd && ei < ne) {
+            deqs[served]->value = std::move(enqs[ei]->value);
+            enqs[ei]->state.store(pack(OP_NONE, true),
+                                  std::memory_order_release);
+            ++served;
+            ++ei;
+        }
+
+        // Bulk-append the unmatched enqueues (grow once, then
+        // sequential stores into the ring).
+        if (ei < ne) {
+            std::size_t add = ne - ei;
+            if ((tail_ - head_) + add > cap_)
+                grow_ring((tail_ - head_) + add);
+            for (std::size_t i = ei; i < ne; ++i) {
+                ring_[tail_ & (cap_ - 1)] = std::move(enqs[i]->value);
+                ++tail_;
+                enqs[i]->state.store(pack(OP_NONE, true),
+                                     std::memory_order_release);
+            }
+        }
+
+        // Any dequeue left over saw a genuinely empty queue.
+        for (std::size_t i = 0; i < nd; ++i) {
+            deqs[i]->state.store(pack(OP_NONE, i < served),
+                                 std::memory_order_release);
+        }
+
+        // Bulk dequeues drain in FIFO order after everything else in
+        // this round has been applied.
+        for (std::size_t i = 0; i < nb; ++i) {
+            Request*    r = bulk_deqs[i];
+            std::size_t k = std::min(r->n, tail_ - head_);
+            ring_consume(r->out, k);
+            r->n_done = k;
+            r->state.store(pack(OP_NONE, k != 0),
+                           std::memory_order_release);
+        }
     }
 };
 
 template <typename T>
-thread_local typename FlatCombiningQueue<T>::Request*
-    FlatCombiningQueue<T>::tls_req_ = nullptr;
+thread_local typename FlatCombiningQueue<T>::TlsSlot
+    FlatCombiningQueue<T>::tls_req_ = {0, nullptr};
@@ -1,98 +1,254 @@
 #pragma once
 
 #include "common.h"
-#include <vector>
-#include <list>
-#include <mutex>
 #include <atomic>
+#include <memory>
 
 template <typename T>
 class FlatCombiningStack {
 public:
     FlatCombiningStack() = default;
 
-    void push(const T& v)
+    void push(const T& v) { push_impl(v); }
+    void push(T&& v) { push_impl(std::move(v)); }
+
+    bool pop(T& out)
     {
         Request& r = get_request();
-        r.value    = v;
-        r.success  = true;  // push always succeeds
-        r.op.store(Request::Op::PUSH, std::memory_order_release);
+        r.state.store(pack(OP_POP, false), std::memory_order_release);
 
-        combine();
-        // after combine(), our request has been processed
+        std::uint32_t st = wait_or_combine(r);
+        // the acquire load that saw OP_NONE also orders value/success
+        if (st & SUCCESS_BIT)
+            out = std::move(r.value);
+        return (st & SUCCESS_BIT) != 0;
     }
 
-    bool pop(T& out)
+    // Lock-free size hint, refreshed by the combiner once per drain.
+    // It was always only a momentary observation; now reading it no
+    // longer stalls behind an active combiner.
+    bool empty() const
+    {
+        return size_hint_.load(std::memory_order_acquire) == 0;
+    }
+
+private:
+    template <typename U>
+    void push_impl(U&& v)
     {
         Request& r = get_request();
-        r.success  = false;
-        r.op.store(Request::Op::POP, std::memory_order_release);
-
-        combine();
-        // after combine(), success/value are stable
-        if (r.success)
-            out = r.value;
-        return r.success;
+        r.value    = std::forward<U>(v);
+        r.state.store(pack(OP_PUSH, true), std::memory_order_release);
+
+        wait_or_combine(r);
+        // our request has been processed (push always succeeds)
     }
 
-    bool empty()
+    // Op and success flag packed into one atomic word: the combiner
+    // finishes a request with a single release store, and the waiter's
+    // acquire load of OP_NONE orders the success bit and value with it
+    // (a separate plain `success` member had no such ordering on the
+    // lock-free path).
+    static constexpr std::uint32_t OP_NONE     = 0;
+    static constexpr std::uint32_t OP_PUSH     = 1;
+    static constexpr std::uint32_t OP_POP      = 2;
+    static constexpr std::uint32_t OP_MASK     = 0x3;
+    static constexpr std::uint32_t SUCCESS_BIT = 0x4;
+
+    static constexpr std::uint32_t pack(std::uint32_t op, bool success)
     {
-        std::lock_guard<std::mutex> lk(combine_m_);
-        return data_.empty();
+        return op | (success ? SUCCESS_BIT : 0);
     }
 
-private:
-    struct Request {
-        enum class Op { NONE, PUSH, POP };
-        std::atomic<Op> op{Op::NONE};
-        T               value{};
-        bool            success{false};
+    struct alignas(64) Request {
+        std::atomic<std::uint32_t> state{OP_NONE};
+        T                          value{};
+        Request*                   pub_next{nullptr};  // intrusive publication link
     };
 
-    std::mutex          combine_m_;
-    std::vector<T>      data_;
-    std::list<Request*> requests_;
+    // Publication list (Hendler/Incze/Shavit style): threads publish
+    // request records lock-free; whoever wins combiner_active_ drains
+    // every pending record, so the fast path is one CAS, no mutex.
+    std::atomic<bool>     combiner_active_{false};
+    std::atomic<Request*> pub_head_{nullptr};
 
-    // Pointer, not object: lifetime not tied to thread exit
-    thread_local static Request* tls_req_;
+    // Contiguous power-of-two ring; only touched while holding the
+    // combiner role, so no atomics. For LIFO only the top index moves,
+    // and the combiner's walk is prefetch-friendly with no per-chunk
+    // indirection or growth-time surprises mid-drain.
+    std::unique_ptr<T[]> ring_{new T[INITIAL_CAP]};
+    std::size_t          cap_{INITIAL_CAP};
+    std::size_t          size_{0};
+
+    // Published copy of size_ for lock-free empty()
+    std::atomic<std::size_t> size_hint_{0};
+
+    static constexpr std::size_t INITIAL_CAP = 4096;
+
+    // Requests drained per combining round; bounds the stack scratch
+    // space and keeps any one round short under heavy load.
+    static constexpr std::size_t COMBINE_BATCH = 32;
+
+    void grow_ring(std::size_t need)
+    {
+        std::size_t new_cap = cap_;
+        while (new_cap < need)
+            new_cap *= 2;
+        std::unique_ptr<T[]> nr{new T[new_cap]};
+        for (std::size_t i = 0; i < size_; ++i)
+            nr[i] = std::move(ring_[i]);
+        ring_ = std::move(nr);
+        cap_  = new_cap;
+    }
+
+    // One record per (thread, instance). Records are never freed: they
+    // stay on the publication list for the life of the container (tiny
+    // bounded leak, same policy as before). Instances are identified by
+    // a monotonic id rather than `this`, because a new stack can be
+    // allocated at the address of a destroyed one.
+    inline static std::atomic<std::uint64_t> next_instance_id_{1};
+    const std::uint64_t instance_id_{
+        next_instance_id_.fetch_add(1, std::memory_order_relaxed)};
+
+    struct TlsSlot {
+        std::uint64_t owner;
+        Request*      req;
+    };
+    thread_local static TlsSlot tls_req_;
 
     Request& get_request()
     {
-        // One Request per thread, allocated once and registered under lock
-        if (!tls_req_) {
-            auto* r = new Request();  // intentionally never freed (tiny bounded leak)
-            {
-                std::lock_guard<std::mutex> lk(combine_m_);
-                requests_.push_back(r);
+        // Re-key when this thread first touches this instance, so a
+        // record from a previous (possibly destroyed) stack is never
+        // reused against the wrong publication list.
+        if (tls_req_.owner != instance_id_) {
+            auto* r = new Request();  // intentionally never freed
+            Request* head = pub_head_.load(std::memory_order_relaxed);
+            do {
+                r->pub_next = head;
+            } while (!pub_head_.compare_exchange_weak(
+                head, r,
+                std::memory_order_release,
+                std::memory_order_relaxed));
+            tls_req_ = {instance_id_, r};
+        }
+        return *tls_req_.req;
+    }
+
+    // Either become the combiner and drain everything (including our own
+    // request, which is already published), or spin until some other
+    // combiner completes our request for us.
+    std::uint32_t wait_or_combine(Request& r)
+    {
+        while (true) {
+            if (!combiner_active_.exchange(true, std::memory_order_acq_rel)) {
+                combine();
+                combiner_active_.store(false, std::memory_order_release);
+                // our record was on the list before the drain
+                return r.state.load(std::memory_order_relaxed);
+            }
+
+            // Lost the election: wait briefly on our own record, then
+            // go try to become the combiner again.
+            for (int i = 0; i < 64; ++i) {
+                std::uint32_t st = r.state.load(std::memory_order_acquire);
+                if ((st & OP_MASK) == OP_NONE)
+                    return st;
+                cpu_relax();
             }
-            tls_req_ = r;
         }
-        return *tls_req_;
     }
 
+    // Runs only while we hold combiner_active_, so the ring needs no lock.
+    // Requests are drained in bounded batches: each round snapshots up
+    // to COMBINE_BATCH ready records into a contiguous stack array, so
+    // the serving passes run over plain pointers instead of re-chasing
+    // the publication list.
     void combine()
     {
-        std::lock_guard<std::mutex> lk(combine_m_);
-        for (Request* r : requests_) {
-            auto op = r->op.load(std::memory_order_acquire);
-            if (op == Request::Op::PUSH) {
-                data_.push_back(r->value);
-                // success already true
-                r->op.store(Request::Op::NONE, std::memory_order_release);
-            } else if (op == Request::Op::POP) {
-                if (!data_.empty()) {
-                    r->value   = data_.back();
-                    data_.pop_back();
-                    r->success = true;
-                } else {
-                    r->success = false;
-                }
-                r->op.store(Request::Op::NONE, std::memory_order_release);
+        while (true) {
+            Request*    ready[COMBINE_BATCH];
+            std::size_t nr = 0;
+            for (Request* r = pub_head_.load(std::memory_order_acquire);
+                 r != nullptr && nr < COMBINE_BATCH;
+                 r = r->pub_next) {
+                __builtin_prefetch(r->pub_next);
+                if ((r->state.load(std::memory_order_acquire) & OP_MASK) !=
+                    OP_NONE)
+                    ready[nr++] = r;
+            }
+            if (nr == 0)
+                break;
+
+            // Dispatch on batch size: a compile-time bound on the
+            // scratch arrays lets the compiler unroll the small cases.
+            if (nr <= 4)
+                drain<4>(ready, nr);
+            else if (nr <= 16)
+                drain<16>(ready, nr);
+            else
+                drain<COMBINE_BATCH>(ready, nr);
+
+            // A short batch means the walk saw every ready record.
+            if (nr < COMBINE_BATCH)
+                break;
+        }
+
+        size_hint_.store(size_, std::memory_order_release);
+    }
+
+    template <std::size_t N>
+    void drain(Request* const* ready, std::size_t nr)
+    {
+        Request*    pushes[N];
+        Request*    pops[N];
+        std::size_t np = 0;
+        std::size_t no = 0;
+        for (std::size_t i = 0; i < nr; ++i) {
+            std::uint32_t op =
+                ready[i]->state.load(std::memory_order_relaxed) & OP_MASK;
+            if (op == OP_PUSH)
+                pushes[np++] = ready[i];
+            else
+                pops[no++] = ready[i];
+        }
+
+        // Eliminate matched push/pop pairs peer-to-peer. For LIFO a
+        // push immediately followed by a pop is always linearizable,
+        // so the shared ring is never touched.
+        while (np > 0 && no > 0) {
+            Request* pu = pushes[--np];
+            Request* po = pops[--no];
+            po->value = std::move(pu->value);
+            pu->state.store(pack(OP_NONE, true), std::memory_order_release);
+            po->state.store(pack(OP_NONE, true), std::memory_order_release);
+        }
+
+        // Bulk-append the unmatched pushes (grow once, then sequential
+        // stores into the ring).
+        if (np > 0) {
+            if (size_ + np > cap_)
+                grow_ring(size_ + np);
+            for (std::size_t i = 0; i < np; ++i) {
+                ring_[size_++] = std::move(pushes[i]->value);
+                pushes[i]->state.store(pack(OP_NONE, true),
+                                       std::memory_order_release);
+            }
+        }
+
+        // Serve unmatched pops straight off the top of the ring.
+        if (no > 0) {
+            std::size_t n = std::min(no, size_);
+            for (std::size_t i = 0; i < n; ++i)
+                pops[i]->value = std::move(ring_[--size_]);
+            for (std::size_t i = 0; i < no; ++i) {
+                pops[i]->state.store(pack(OP_NONE, i < n),
+                                     std::memory_order_release);
             }
         }
     }
 };
 
 template <typename T>
-thread_local typename FlatCombiningStack<T>::Request*
-    FlatCombiningStack<T>::tls_req_ = nullptr;
+thread_local typename FlatCombiningStack<T>::TlsSlot
+    FlatCombiningStack<T>::tls_req_ = {0, nullptr};
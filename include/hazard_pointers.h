@@ -12,8 +12,9 @@ inline constexpr std::size_t HAZARD_SLOTS_PER_THREAD = 2;
 inline constexpr std::size_t MAX_HAZARD_POINTERS =
     MAX_THREADS * HAZARD_SLOTS_PER_THREAD;
 
-// A single hazard pointer record
-struct HazardRecord {
+// A single hazard pointer record, one per cache line so per-slot
+// writes from different threads don't share lines
+struct alignas(64) HazardRecord {
     std::atomic<std::thread::id> owner;
     std::atomic<void*>           ptr;
 
@@ -22,24 +23,48 @@ struct HazardRecord {
 
 inline HazardRecord g_hazard_records[MAX_HAZARD_POINTERS];
 
-// Acquire a hazard pointer slot for this thread
-inline HazardRecord* acquire_hazard_record()
+// Per-thread cache of claimed records. Without it every
+// HazardPointerOwner construction re-scanned all 128 records comparing
+// std::thread::id; with it the scan happens once per thread lifetime
+// per slot and later acquisitions are a plain array read. The records
+// are handed back (owner reset) when the thread exits, so slots are
+// reused across thread churn.
+struct ThreadHazardSlots {
+    HazardRecord* slots[HAZARD_SLOTS_PER_THREAD] = {};
+    int           top = 0;
+
+    ~ThreadHazardSlots()
+    {
+        std::thread::id empty_id{};
+        for (auto* rec : slots) {
+            if (rec) {
+                rec->ptr.store(nullptr, std::memory_order_release);
+                rec->owner.store(empty_id, std::memory_order_release);
+            }
+        }
+    }
+};
+
+inline ThreadHazardSlots& thread_hazard_slots()
 {
-    std::thread::id empty_id{};
-    std::thread::id me = std::this_thread::get_id();
+    thread_local ThreadHazardSlots ts;
+    return ts;
+}
 
-    // Try to reuse existing record
-    for (auto& rec : g_hazard_records) {
-        
-        if (rec.owner.load(std::memory_order_relaxed) == me)
-            return &rec;
-    }
+// Acquire this thread's idx-th hazard record, claiming one from the
+// global array only on first use
+inline HazardRecord* acquire_hazard_slot(int idx)
+{
+    ThreadHazardSlots& ts = thread_hazard_slots();
+    if (HazardRecord* cached = ts.slots[idx])
+        return cached;
 
-    // Grab a free one
+    std::thread::id me = std::this_thread::get_id();
     for (auto& rec : g_hazard_records) {
         std::thread::id expected{};
         if (rec.owner.compare_exchange_strong(
                 expected, me, std::memory_order_acq_rel)) {
+            ts.slots[idx] = &rec;
             return &rec;
         }
     }
@@ -53,7 +78,9 @@ class HazardPointerOwner {
 public:
     HazardPointerOwner()
     {
-        rec_ = acquire_hazard_record();
+        idx_ = thread_hazard_slots().top++;
+        assert(idx_ < static_cast<int>(HAZARD_SLOTS_PER_THREAD));
+        rec_ = acquire_hazard_slot(idx_);
     }
 
     HazardPointerOwner(const HazardPointerOwner&) = delete;
@@ -62,6 +89,7 @@ public:
     ~HazardPointerOwner()
     {
         clear();
+        --thread_hazard_slots().top;
     }
 
     void set(void* p)
@@ -76,6 +104,7 @@ public:
 
 private:
     HazardRecord* rec_{nullptr};
+    int           idx_{0};
 };
 
 // Collect all hazard pointer values currently in use
@@ -90,15 +119,14 @@ inline void collect_hazard_pointers(std::vector<void*>& out)
     }
 }
 
-// Per-thread retired list and reclamation logic
-template <typename T>
+// Per-thread retired list and reclamation logic. The deleter is a
+// compile-time parameter so the default case is a direct, inlinable
+// `delete` rather than an indirect call through std::function in the
+// reclamation loop.
+template <typename T, class D = std::default_delete<T>>
 class RetiredList {
 public:
-    using Deleter = std::function<void(T*)>;
-
-    explicit RetiredList(Deleter d = [](T* p) { delete p; })
-        : deleter_(std::move(d))
-    {}
+    explicit RetiredList(D d = D{}) : deleter_(std::move(d)) {}
 
     void retire(T* node)
     {
@@ -119,10 +147,36 @@ private:
         std::vector<void*> hp_values;
         collect_hazard_pointers(hp_values);
 
-        auto is_hazard = [&hp_values](void* p) {
-            return std::find(hp_values.begin(), hp_values.end(), p) !=
-                   hp_values.end();
+        // Open-addressing hash set over the collected hazards, built
+        // once per scan. 256 slots for <=128 hazards keeps the load
+        // factor at 0.5, so probe chains stay tiny and lookup is O(1)
+        // instead of a std::find over the whole vector per retired node.
+        std::array<void*, 256> table{};
+        auto slot_of = [](void* p) {
+            return static_cast<std::size_t>(
+                (reinterpret_cast<std::uintptr_t>(p) *
+                 0x9E3779B97F4A7C15ull) >> 56);
         };
+        for (void* p : hp_values) {
+            std::size_t i = slot_of(p);
+            while (table[i] != nullptr && table[i] != p)
+                i = (i + 1) & (table.size() - 1);
+            table[i] = p;
+        }
+
+        auto is_hazard = [&table, &slot_of](void* p) {
+            std::size_t i = slot_of(p);
+            while (table[i] != nullptr) {
+                if (table[i] == p)
+                    return true;
+                i = (i + 1) & (table.size() - 1);
+            }
+            return false;
+        };
+
+        // Delete in address order: the reclamation loop then walks pages
+        // monotonically, which is kinder to the dcache and TLB.
+        std::sort(retired_.begin(), retired_.end());
 
         std::vector<T*> kept;
         kept.reserve(retired_.size());
@@ -138,9 +192,9 @@ private:
         retired_.swap(kept);
     }
 
-    std::vector<T*> retired_;
-    Deleter         deleter_;
-    std::size_t     threshold_ = 64; // tune if needed
+    std::vector<T*>          retired_;
+    [[no_unique_address]] D  deleter_;
+    std::size_t              threshold_ = 64; // tune if needed
 };
 
 // Get per-thread retired list
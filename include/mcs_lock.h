@@ -0,0 +1,82 @@
+#pragma once
+
+#include "common.h"
+
+// MCS queue lock (Mellor-Crummey/Scott).
+//
+// Waiters form an explicit FIFO queue and each spins on a flag in its
+// own stack-allocated node, so a hand-off invalidates exactly one cache
+// line instead of broadcasting to every waiter. Release is O(1): store
+// to the successor's flag. Unlike std::mutex there is no futex round
+// trip through the kernel per hand-off, which matters when the critical
+// section is a handful of instructions.
+class MCSLock {
+public:
+    struct alignas(64) Node {
+        std::atomic<Node*> next{nullptr};
+        std::atomic<bool>  locked{false};
+    };
+
+    void lock(Node& self)
+    {
+        self.next.store(nullptr, std::memory_order_relaxed);
+        Node* pred = tail_.exchange(&self, std::memory_order_acq_rel);
+        if (pred != nullptr) {
+            self.locked.store(true, std::memory_order_relaxed);
+            pred->next.store(&self, std::memory_order_release);
+            // Spin briefly, then yield: if the holder (or our
+            // predecessor) has been preempted, burning the rest of our
+            // timeslice only delays it further.
+            int spins = 0;
+            while (self.locked.load(std::memory_order_acquire)) {
+                if (++spins < SPIN_LIMIT)
+                    cpu_relax();
+                else
+                    std::this_thread::yield();
+            }
+        }
+    }
+
+    void unlock(Node& self)
+    {
+        Node* succ = self.next.load(std::memory_order_acquire);
+        if (succ == nullptr) {
+            // No visible successor: try to close the queue. If the CAS
+            // fails, someone swung tail_ but has not linked in yet.
+            Node* expected = &self;
+            if (tail_.compare_exchange_strong(
+                    expected, nullptr, std::memory_order_acq_rel))
+                return;
+            int spins = 0;
+            while ((succ = self.next.load(std::memory_order_acquire)) ==
+                   nullptr) {
+                if (++spins < SPIN_LIMIT)
+                    cpu_relax();
+                else
+                    std::this_thread::yield();
+            }
+        }
+        succ->locked.store(false, std::memory_order_release);
+    }
+
+    // RAII wrapper, mirrors std::lock_guard; the queue node lives in
+    // the guard itself, i.e. on the caller's stack.
+    class Guard {
+    public:
+        explicit Guard(MCSLock& lock) : lock_(lock) { lock_.lock(node_); }
+        ~Guard() { lock_.unlock(node_); }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+    private:
+        MCSLock& lock_;
+        Node     node_;
+    };
+
+private:
+    // In-core spins before falling back to the scheduler
+    static constexpr int SPIN_LIMIT = 256;
+
+    std::atomic<Node*> tail_{nullptr};
+};
@@ -1,127 +1,219 @@
 #pragma once
 
 #include "common.h"
-#include "hazard_pointers.h"
+#include "ebr.h"
+#include <array>
 #include <optional>
 
+// FIFO queue with fetch_add-based enqueue (Morrison/Afek LCRQ style).
+//
+// Values live in fixed-size segments of cells. A producer claims a cell
+// with one fetch_add on the segment's enqueue index and publishes it
+// with one CAS on the cell state — there is no CAS-retry race on a
+// shared tail pointer as in classic Michael-Scott, so producers do not
+// spin against each other on the common path. A consumer claims a cell
+// with a fetch_add on the dequeue index; if the owning producer has not
+// filled it yet, the consumer poisons the cell (EMPTY -> TAKEN) and the
+// producer moves on to the next index. Drained segments are unlinked
+// and retired through EBR.
 template <typename T>
-class MSQueue {
+class alignas(64) MSQueue {
 private:
-    struct Node {
-        std::atomic<Node*> next;
-        std::optional<T>   value;
+    static constexpr std::size_t SEG_SIZE   = 256;
+    static constexpr int         CELL_SPINS = 128;
 
-        Node() : next(nullptr), value(std::nullopt) {}        // dummy
-        explicit Node(const T& v) : next(nullptr), value(v) {} // real
+    enum CellState : int { EMPTY = 0, FULL = 1, TAKEN = 2 };
+
+    struct Cell {
+        std::atomic<int> state{EMPTY};
+        std::optional<T> value;
+    };
+
+    struct Segment {
+        std::atomic<Segment*> next{nullptr};
+        // Producer and consumer indexes each on their own line: both
+        // sides hammer them with fetch_add.
+        Padded<std::uint64_t> enq_idx;
+        Padded<std::uint64_t> deq_idx;
+        std::array<Cell, SEG_SIZE> cells;
     };
 
-    std::atomic<Node*> head_;
-    std::atomic<Node*> tail_;
+    // head_ and tail_ are hammered by different threads; keep them on
+    // separate cache lines so a CAS on one does not invalidate the other.
+    Padded<Segment*> head_;
+    Padded<Segment*> tail_;
 
 public:
     MSQueue()
     {
-        Node* dummy = new Node(); // sentinel node
-        head_.store(dummy, std::memory_order_relaxed);
-        tail_.store(dummy, std::memory_order_relaxed);
+        Segment* seg = new Segment();
+        head_.v.store(seg, std::memory_order_relaxed);
+        tail_.v.store(seg, std::memory_order_relaxed);
     }
 
     ~MSQueue()
     {
-        // Drain nodes (single-threaded, so no hazard pointers needed)
-        Node* n = head_.load(std::memory_order_relaxed);
-        while (n) {
-            Node* next = n->next.load(std::memory_order_relaxed);
-            delete n;
-            n = next;
+        // Drain segments (single-threaded, so no EBR needed)
+        Segment* seg = head_.v.load(std::memory_order_relaxed);
+        while (seg) {
+            Segment* next = seg->next.load(std::memory_order_relaxed);
+            delete seg;
+            seg = next;
         }
     }
 
-    void enqueue(const T& value)
+    void enqueue(const T& value) { enqueue_impl(value); }
+    void enqueue(T&& value) { enqueue_impl(std::move(value)); }
+
+private:
+    template <typename U>
+    void enqueue_impl(U&& value)
     {
-        Node* new_node = new Node(value);
+        ebr::Guard g;
+
+        // Own the value locally: a poisoned cell hands it back, so the
+        // caller's argument is only ever touched once.
+        T tmp(std::forward<U>(value));
 
         while (true) {
-            Node* tail = tail_.load(std::memory_order_acquire);
-            Node* next = tail->next.load(std::memory_order_acquire);
-
-            if (tail == tail_.load(std::memory_order_acquire)) {
-                if (next == nullptr) {
-                    // Tail is the real last node
-                    if (tail->next.compare_exchange_weak(
-                            next,
-                            new_node,
-                            std::memory_order_acq_rel,
-                            std::memory_order_acquire)) {
-                        // Try to swing tail to new node (best-effort)
-                        tail_.compare_exchange_strong(
-                            tail,
-                            new_node,
-                            std::memory_order_acq_rel,
-                            std::memory_order_relaxed);
-                        return;
-                    }
-                } else {
-                    // Tail is behind, advance it
-                    tail_.compare_exchange_strong(
-                        tail,
-                        next,
+            Segment*      seg = tail_.v.load(std::memory_order_acquire);
+            std::uint64_t i =
+                seg->enq_idx.v.fetch_add(1, std::memory_order_acq_rel);
+
+            if (i < SEG_SIZE) {
+                Cell& c = seg->cells[i];
+                c.value.emplace(std::move(tmp));
+                int expected = EMPTY;
+                if (c.state.compare_exchange_strong(
+                        expected, FULL,
+                        std::memory_order_release,
+                        std::memory_order_relaxed)) {
+                    return;
+                }
+                // A consumer poisoned this cell while we were filling
+                // it; the value is never read. Take it back and claim
+                // the next index.
+                tmp = std::move(*c.value);
+                continue;
+            }
+
+            // Segment exhausted: install or advance to the next one.
+            Segment* next = seg->next.load(std::memory_order_acquire);
+            if (next == nullptr) {
+                // Pre-fill slot 0 of the fresh segment with our value so
+                // a successful link CAS completes the enqueue outright.
+                Segment* fresh = new Segment();
+                fresh->cells[0].value.emplace(std::move(tmp));
+                fresh->cells[0].state.store(FULL, std::memory_order_relaxed);
+                fresh->enq_idx.v.store(1, std::memory_order_relaxed);
+
+                Segment* expected = nullptr;
+                if (seg->next.compare_exchange_strong(
+                        expected, fresh,
+                        std::memory_order_acq_rel,
+                        std::memory_order_acquire)) {
+                    tail_.v.compare_exchange_strong(
+                        seg, fresh,
                         std::memory_order_acq_rel,
                         std::memory_order_relaxed);
+                    return;
                 }
+                tmp = std::move(*fresh->cells[0].value);
+                delete fresh;  // someone else linked first
+                next = expected;
             }
+            tail_.v.compare_exchange_strong(
+                seg, next,
+                std::memory_order_acq_rel,
+                std::memory_order_relaxed);
         }
     }
 
+public:
     bool dequeue(T& out)
     {
-        hp::HazardPointerOwner hp_head;
-
-        while (true) {
-            Node* head = head_.load(std::memory_order_acquire);
-            hp_head.set(head);
+        ebr::Guard g;
+        return dequeue_impl(out);
+    }
 
-            Node* tail = tail_.load(std::memory_order_acquire);
-            Node* next = head->next.load(std::memory_order_acquire);
+    // Dequeue up to max_n values under one EBR guard entry, amortizing
+    // the guard's fence over the batch; returns how many were dequeued.
+    std::size_t bulk_dequeue(T* out, std::size_t max_n)
+    {
+        ebr::Guard g;
+        std::size_t n = 0;
+        while (n < max_n && dequeue_impl(out[n]))
+            ++n;
+        return n;
+    }
 
-            if (head != head_.load(std::memory_order_acquire))
-                continue; // changed, retry
+private:
+    // Caller holds an ebr::Guard
+    bool dequeue_impl(T& out)
+    {
+        while (true) {
+            Segment* seg = head_.v.load(std::memory_order_acquire);
 
-            if (next == nullptr) {
-                // Queue is empty
+            // Fast empty check before claiming a slot: polling an empty
+            // queue must not burn dequeue indexes.
+            if (seg->next.load(std::memory_order_acquire) == nullptr &&
+                seg->deq_idx.v.load(std::memory_order_acquire) >=
+                    seg->enq_idx.v.load(std::memory_order_acquire)) {
                 return false;
             }
 
-            if (head == tail) {
-                // Tail is falling behind, advance it
-                tail_.compare_exchange_strong(
-                    tail,
-                    next,
-                    std::memory_order_acq_rel,
-                    std::memory_order_relaxed);
-                continue;
-            } else {
-                // There is real data in next
-                if (head_.compare_exchange_strong(
-                        head,
-                        next,
+            std::uint64_t i =
+                seg->deq_idx.v.fetch_add(1, std::memory_order_acq_rel);
+
+            if (i >= SEG_SIZE) {
+                // Every cell was claimed exactly once, so the segment is
+                // drained; advance head and retire it.
+                Segment* next = seg->next.load(std::memory_order_acquire);
+                if (next == nullptr)
+                    return false;
+                if (head_.v.compare_exchange_strong(
+                        seg, next,
                         std::memory_order_acq_rel,
-                        std::memory_order_acquire)) {
-                    // We moved head forward, safe to read next->value
-                    out = *(next->value);
-                    hp_head.clear();
-                    // retire old head
-                    hp::retired_list<Node>().retire(head);
+                        std::memory_order_relaxed)) {
+                    ebr::retire_list<Segment>().retire(seg);
+                }
+                continue;
+            }
+
+            Cell& c = seg->cells[i];
+
+            // Wait briefly for the producer that claimed this cell
+            for (int spin = 0; spin < CELL_SPINS; ++spin) {
+                if (c.state.load(std::memory_order_acquire) == FULL) {
+                    out = std::move(*c.value);
                     return true;
                 }
+                cpu_relax();
             }
+
+            // Producer absent or slow: poison the cell so its producer
+            // skips to the next index, and move on ourselves.
+            int expected = EMPTY;
+            if (c.state.compare_exchange_strong(
+                    expected, TAKEN,
+                    std::memory_order_acq_rel,
+                    std::memory_order_acquire)) {
+                continue;
+            }
+
+            // The producer published between our last check and the CAS
+            out = std::move(*c.value);
+            return true;
         }
     }
 
+public:
     bool empty() const
     {
-        Node* head = head_.load(std::memory_order_acquire);
-        Node* next = head->next.load(std::memory_order_acquire);
-        return next == nullptr;
+        ebr::Guard g;
+        Segment* seg = head_.v.load(std::memory_order_acquire);
+        return seg->next.load(std::memory_order_acquire) == nullptr &&
+               seg->deq_idx.v.load(std::memory_order_acquire) >=
+                   seg->enq_idx.v.load(std::memory_order_acquire);
     }
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "common.h"
+#include "mcs_lock.h"
 #include <deque>
 
 template <typename T>
@@ -10,33 +11,57 @@ public:
 
     void enqueue(const T& value)
     {
-        std::lock_guard<std::mutex> lk(m_);
+        MCSLock::Guard lk(m_);
         data_.push_back(value);
+        size_.store(data_.size(), std::memory_order_release);
+    }
+
+    void enqueue(T&& value)
+    {
+        MCSLock::Guard lk(m_);
+        data_.push_back(std::move(value));
+        size_.store(data_.size(), std::memory_order_release);
     }
 
     bool dequeue(T& out)
     {
-        std::lock_guard<std::mutex> lk(m_);
+        MCSLock::Guard lk(m_);
         if (data_.empty())
             return false;
-        out = data_.front();
+        out = std::move(data_.front());
         data_.pop_front();
+        size_.store(data_.size(), std::memory_order_release);
         return true;
     }
 
+    // Dequeue up to max_n values under one lock acquisition; returns
+    // how many were actually dequeued.
+    std::size_t bulk_dequeue(T* out, std::size_t max_n)
+    {
+        MCSLock::Guard lk(m_);
+        std::size_t n = std::min(max_n, data_.size());
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = std::move(data_.front());
+            data_.pop_front();
+        }
+        size_.store(data_.size(), std::memory_order_release);
+        return n;
+    }
+
+    // empty()/size() read the counter lock-free: pollers no longer
+    // fight writers for the mutex just to observe a momentary size.
     bool empty() const
     {
-        std::lock_guard<std::mutex> lk(m_);
-        return data_.empty();
+        return size_.load(std::memory_order_acquire) == 0;
     }
 
     std::size_t size() const
     {
-        std::lock_guard<std::mutex> lk(m_);
-        return data_.size();
+        return size_.load(std::memory_order_acquire);
     }
 
 private:
-    mutable std::mutex m_;
-    std::deque<T>      data_;
+    mutable MCSLock          m_;
+    std::deque<T>            data_;
+    std::atomic<std::size_t> size_{0};
 };
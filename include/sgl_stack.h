@@ -1,6 +1,7 @@
 #pragma once
 
 #include "common.h"
+#include "mcs_lock.h"
 #include <vector>
 
 template <typename T>
@@ -10,33 +11,43 @@ public:
 
     void push(const T& value)
     {
-        std::lock_guard<std::mutex> lk(m_);
+        MCSLock::Guard lk(m_);
         data_.push_back(value);
+        size_.store(data_.size(), std::memory_order_release);
+    }
+
+    void push(T&& value)
+    {
+        MCSLock::Guard lk(m_);
+        data_.push_back(std::move(value));
+        size_.store(data_.size(), std::memory_order_release);
     }
 
     bool pop(T& out)
     {
-        std::lock_guard<std::mutex> lk(m_);
+        MCSLock::Guard lk(m_);
         if (data_.empty())
             return false;
-        out = data_.back();
+        out = std::move(data_.back());
         data_.pop_back();
+        size_.store(data_.size(), std::memory_order_release);
         return true;
     }
 
+    // empty()/size() read the counter lock-free: pollers no longer
+    // fight writers for the mutex just to observe a momentary size.
     bool empty() const
     {
-        std::lock_guard<std::mutex> lk(m_);
-        return data_.empty();
+        return size_.load(std::memory_order_acquire) == 0;
     }
 
     std::size_t size() const
     {
-        std::lock_guard<std::mutex> lk(m_);
-        return data_.size();
+        return size_.load(std::memory_order_acquire);
     }
 
 private:
-    mutable std::mutex m_;
-    std::vector<T>     data_;
+    mutable MCSLock          m_;
+    std::vector<T>           data_;
+    std::atomic<std::size_t> size_{0};
 };
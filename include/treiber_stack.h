@@ -1,15 +1,19 @@
 #pragma once
 
+#include "backoff.h"
 #include "common.h"
-#include "hazard_pointers.h"
+#include "ebr.h"
+#include "node_pool.h"
 
-template <typename T>
+// Backoff is consulted after each failed CAS on head_; see backoff.h.
+template <typename T, typename Backoff = ExpBackoff>
 class TreiberStack {
 private:
     struct Node {
         T     value;
         Node* next;
         explicit Node(const T& v) : value(v), next(nullptr) {}
+        explicit Node(T&& v) : value(std::move(v)), next(nullptr) {}
     };
 
     std::atomic<Node*> head_{nullptr};
@@ -23,56 +27,40 @@ public:
         Node* n = head_.load(std::memory_order_relaxed);
         while (n) {
             Node* next = n->next;
-            delete n;
+            NodePool<Node>::free(n);
             n = next;
         }
     }
 
-    void push(const T& value)
-    {
-        Node* new_node = new Node(value);
-        new_node->next = nullptr;
-
-        Node* old_head = head_.load(std::memory_order_relaxed);
-        do {
-            new_node->next = old_head;
-        } while (!head_.compare_exchange_weak(
-            old_head,
-            new_node,
-            std::memory_order_release,
-            std::memory_order_relaxed));
-    }
+    void push(const T& value) { push_impl(value); }
+    void push(T&& value) { push_impl(std::move(value)); }
 
     bool pop(T& out)
     {
-        hp::HazardPointerOwner hpo;
-        Node*                  old_head = nullptr;
-
-        while (true) {
-            old_head = head_.load(std::memory_order_acquire);
-            if (!old_head) {
-                hpo.clear();
-                return false;
-            }
-            hpo.set(old_head); // protect old_head
-
-            // Re-read to ensure consistency
-            if (old_head != head_.load(std::memory_order_acquire))
-                continue;
+        // The guard pins the current epoch: no node unlinked from here
+        // on can be freed until we leave, so no per-attempt publication
+        // or re-read of head_ is needed.
+        ebr::Guard g;
 
+        Node* old_head = head_.load(std::memory_order_acquire);
+        int   attempt  = 0;
+        while (old_head) {
             Node* next = old_head->next;
             if (head_.compare_exchange_weak(
                     old_head,
                     next,
                     std::memory_order_acq_rel,
                     std::memory_order_acquire)) {
-                break; // success
+                break; // success; on failure old_head is reloaded
             }
+            Backoff::on_cas_fail(attempt++);
         }
 
-        out = old_head->value;
-        hpo.clear();
-        hp::retired_list<Node>().retire(old_head);
+        if (!old_head)
+            return false;
+
+        out = std::move(old_head->value);
+        ebr::retire_list<Node, PoolDeleter<Node>>().retire(old_head);
         return true;
     }
 
@@ -80,4 +68,24 @@ public:
     {
         return head_.load(std::memory_order_acquire) == nullptr;
     }
+
+private:
+    template <typename U>
+    void push_impl(U&& value)
+    {
+        Node* new_node = NodePool<Node>::alloc(std::forward<U>(value));
+        new_node->next = nullptr;
+
+        Node* old_head = head_.load(std::memory_order_relaxed);
+        int   attempt  = 0;
+        do {
+            new_node->next = old_head;
+            if (head_.compare_exchange_weak(old_head,
+                                            new_node,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed))
+                return;
+            Backoff::on_cas_fail(attempt++);
+        } while (true);
+    }
 };
@@ -8,16 +8,25 @@
 #include "ms_queue.h"
 #include "flat_combining_queue.h"
 
+#include <barrier>
 #include <chrono>
+#include <functional>
 #include <thread>
 #include <vector>
 #include <string>
 #include <iostream>
-#include <iomanip>
+#include <cstdio>
+#include <sstream>
 #include <atomic>
 
-// Small helper for timing
-using clock_type = std::chrono::high_resolution_clock;
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Small helper for timing. steady_clock: high_resolution_clock aliases
+// system_clock on some libstdc++ builds and can jump mid-run under NTP.
+using clock_type = std::chrono::steady_clock;
 
 struct BenchResult {
     std::string kind;        // "stack" or "queue"
@@ -27,6 +36,7 @@ struct BenchResult {
     std::size_t actual_ops;         // what we actually executed
     double      time_ms;            // wall time in ms
     double      ops_per_sec;        // throughput
+    std::string log;                // per-run report, printed after the sweep
 };
 
 // ---------------------------------------------------------------------------
@@ -42,64 +52,120 @@ struct BenchResult {
 // ---------------------------------------------------------------------------
 
 template <typename Stack>
-BenchResult bench_stack_const_total(const std::string& name,
+BenchResult bench_stack_const_total(WorkerPool& pool,
+                                    const std::string& name,
                                     int threads,
-                                    std::size_t total_pushes_requested)
+                                    std::size_t total_ops_requested)
 {
     Stack s;
 
-    std::size_t per_thread = total_pushes_requested / threads;
-    std::size_t actual_pushes = per_thread * threads;
-
-    std::cout << "\n[STACK BENCH] " << name << "\n"
-              << "  threads                : " << threads << "\n"
-              << "  requested total pushes : " << total_pushes_requested << "\n"
-              << "  per-thread pushes      : " << per_thread << "\n"
-              << "  actual total pushes    : " << actual_pushes << "\n";
-
-    auto worker = [&](int id) {
-        // Just generate some simple values
+    std::size_t per_thread = total_ops_requested / threads;
+    std::size_t actual_ops = per_thread * threads;
+
+    // Items present before the mixed phase, so early pops have
+    // something to hit (same methodology as the elimination papers).
+    constexpr std::size_t PREPOPULATE = 1000;
+
+    // Prints are accumulated and emitted after the whole sweep: stdio
+    // locking and flushes between runs would otherwise interleave with
+    // the next run's setup and perturb allocator/TLB state.
+    std::ostringstream log;
+    log << "\n[STACK BENCH] " << name << "\n"
+        << "  threads                : " << threads << "\n"
+        << "  requested total ops    : " << total_ops_requested << "\n"
+        << "  per-thread ops         : " << per_thread << "\n"
+        << "  actual total ops       : " << actual_ops << "\n";
+
+    // Each op counter on its own line; workers only merge at exit
+    Padded<std::size_t> pushes{0};
+    Padded<std::size_t> pops_ok{0};
+
+    // 50/50 push/pop mix. A push-only phase never creates concurrent
+    // push/pop pairs, which reduces EliminationStack and
+    // FlatCombiningStack to their slow paths and makes the comparison
+    // meaningless.
+    std::function<void(int)> worker = [&](int id) {
+        // xorshift128+, seeded per thread
+        std::uint64_t s0 = 0x9E3779B97F4A7C15ull ^ static_cast<std::uint64_t>(id);
+        std::uint64_t s1 = 0xBF58476D1CE4E5B9ull + static_cast<std::uint64_t>(id);
+        auto next = [&]() {
+            std::uint64_t x = s0;
+            const std::uint64_t y = s1;
+            s0 = y;
+            x ^= x << 23;
+            s1 = x ^ y ^ (x >> 17) ^ (y >> 26);
+            return s1 + y;
+        };
+
+        std::size_t local_pushes = 0;
+        std::size_t local_pops   = 0;
+        int x = 0;
         for (std::size_t i = 0; i < per_thread; ++i) {
-            int v = id * static_cast<int>(per_thread) + static_cast<int>(i);
-            s.push(v);
+            std::uint64_t r = next();
+            if (r & 1) {
+                s.push(static_cast<int>(r >> 1));
+                ++local_pushes;
+            } else if (s.pop(x)) {
+                ++local_pops;
+            }
         }
+        pushes.v.fetch_add(local_pushes, std::memory_order_relaxed);
+        pops_ok.v.fetch_add(local_pops, std::memory_order_relaxed);
     };
 
-    std::vector<std::thread> ts;
-    ts.reserve(threads);
+    // Warm up outside the timed window: the first pushes pay for lazy
+    // page mapping, first-touch zeroing and allocator arena setup,
+    // which would otherwise be billed to the measured phase.
+    {
+        std::size_t warm = std::max<std::size_t>(1000, per_thread / 20);
+        int x = 0;
+        for (std::size_t i = 0; i < warm; ++i)
+            s.push(static_cast<int>(i));
+        while (s.pop(x)) {
+        }
+    }
+
+    for (std::size_t i = 0; i < PREPOPULATE; ++i)
+        s.push(static_cast<int>(i));
 
+    // The pool's start barrier releases all workers together right
+    // after t_start, so the window sees T concurrent threads throughout.
     auto t_start = clock_type::now();
-    for (int t = 0; t < threads; ++t)
-        ts.emplace_back(worker, t);
-    for (auto& th : ts)
-        th.join();
+    pool.run(threads, worker);
     auto t_end = clock_type::now();
 
-    auto dur_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t_end - t_start).count();
-    double time_ms = static_cast<double>(dur_ns) / 1e6;
-    double time_s  = static_cast<double>(dur_ns) / 1e9;
-    double throughput = (time_s > 0.0) ? (static_cast<double>(actual_pushes) / time_s) : 0.0;
+    double time_s  = std::chrono::duration<double>(t_end - t_start).count();
+    double time_ms = time_s * 1e3;
 
-    std::cout << "  time (ms)              : " << time_ms << "\n"
-              << "  pushes/sec             : " << throughput << "\n";
+    std::size_t total_pushes = pushes.v.load(std::memory_order_relaxed);
+    std::size_t total_pops   = pops_ok.v.load(std::memory_order_relaxed);
+    std::size_t success_ops  = total_pushes + total_pops;
+    double throughput = (time_s > 0.0) ? (static_cast<double>(success_ops) / time_s) : 0.0;
 
-    // Optional sanity check: pop everything
+    log << "  time (ms)              : " << time_ms << "\n"
+        << "  successful ops         : " << success_ops << "\n"
+        << "  ops/sec                : " << throughput << "\n";
+
+    // Sanity check: what is left must be the prepopulation plus the
+    // push/pop imbalance.
     std::size_t popped = 0;
     int x = 0;
     while (s.pop(x)) {
         ++popped;
     }
-    std::cout << "  sanity: popped count   : " << popped << "\n";
-    check(popped == actual_pushes, (name + " popped != pushed").c_str());
+    log << "  sanity: leftover count : " << popped << "\n";
+    check(popped == PREPOPULATE + total_pushes - total_pops,
+          (name + " leftover != prepopulate + pushes - pops").c_str());
 
     BenchResult res;
     res.kind         = "stack";
     res.name         = name;
     res.threads      = threads;
-    res.requested_ops= total_pushes_requested;
-    res.actual_ops   = actual_pushes;
+    res.requested_ops= total_ops_requested;
+    res.actual_ops   = success_ops;
     res.time_ms      = time_ms;
     res.ops_per_sec  = throughput;
+    res.log          = log.str();
     return res;
 }
 
@@ -117,7 +183,8 @@ BenchResult bench_stack_const_total(const std::string& name,
 // ---------------------------------------------------------------------------
 
 template <typename Queue>
-BenchResult bench_queue_const_total(const std::string& name,
+BenchResult bench_queue_const_total(WorkerPool& pool,
+                                    const std::string& name,
                                     int producers,
                                     std::size_t total_items_requested)
 {
@@ -126,74 +193,131 @@ BenchResult bench_queue_const_total(const std::string& name,
     std::size_t per_producer = total_items_requested / producers;
     std::size_t actual_items = per_producer * producers;
 
-    std::cout << "\n[QUEUE BENCH] " << name << "\n"
-              << "  producers              : " << producers << "\n"
-              << "  requested total items  : " << total_items_requested << "\n"
-              << "  per-producer items     : " << per_producer << "\n"
-              << "  actual total items     : " << actual_items << "\n";
-
-    std::atomic<std::size_t> produced{0};
-    std::atomic<std::size_t> consumed{0};
+    std::ostringstream log;
+    log << "\n[QUEUE BENCH] " << name << "\n"
+        << "  producers              : " << producers << "\n"
+        << "  requested total items  : " << total_items_requested << "\n"
+        << "  per-producer items     : " << per_producer << "\n"
+        << "  actual total items     : " << actual_items << "\n";
+
+    // One counter per cache line: producers hammer `produced` while the
+    // consumer publishes `consumed`; adjacent on the stack they false-share.
+    Padded<std::size_t> produced{0};
+    Padded<std::size_t> consumed{0};
+    // Counted down by each finishing producer; with the pool running
+    // consumer and producers as one job batch, main is no longer free
+    // to flip a flag between joins.
+    std::atomic<int> producers_left{producers};
+
+    // Values are generated before the timed window: computing them
+    // inside the loop put arithmetic on the measured path, which is
+    // noise when enqueue itself is short. xorshift32 rather than a
+    // linear ramp: strictly increasing values give the CPU perfectly
+    // predictable data to speculate past, which real workloads do not.
+    std::vector<std::vector<int>> producer_vals(producers);
+    for (int id = 0; id < producers; ++id) {
+        auto& vals = producer_vals[id];
+        vals.resize(per_producer);
+        std::uint32_t seed = 0x9E3779B9u ^ static_cast<std::uint32_t>(id);
+        for (std::size_t i = 0; i < per_producer; ++i) {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            vals[i] = static_cast<int>(seed);
+        }
+    }
 
     auto producer_fn = [&](int id) {
-        for (std::size_t i = 0; i < per_producer; ++i) {
-            int v = id * static_cast<int>(per_producer) + static_cast<int>(i);
+        for (int v : producer_vals[id]) {
             q.enqueue(v);
-            produced.fetch_add(1, std::memory_order_relaxed);
+            produced.v.fetch_add(1, std::memory_order_relaxed);
         }
+        producers_left.fetch_sub(1, std::memory_order_release);
     };
 
-    std::vector<std::thread> prod_threads;
-    prod_threads.reserve(producers);
-
     auto consumer_fn = [&]() {
         std::size_t local_count = 0;
+        unsigned    backoff     = 1;
         int v = 0;
         while (local_count < actual_items) {
-            if (q.dequeue(v)) {
-                ++local_count;
-                consumed.fetch_add(1, std::memory_order_relaxed);
+            bool got = false;
+            if constexpr (requires(int* p) { q.bulk_dequeue(p, std::size_t{}); }) {
+                // Drain in batches where the queue offers it: one
+                // combiner handoff then covers up to 64 items.
+                int         buf[64];
+                std::size_t n = q.bulk_dequeue(buf, 64);
+                local_count += n;
+                got = n != 0;
+            } else {
+                got = q.dequeue(v);
+                if (got)
+                    ++local_count;
+            }
+            if (got) {
+                // Count locally; publishing `consumed` per dequeue put an
+                // RMW on a shared line in the middle of the hot path.
+                backoff = 1;
             } else {
-                // queue empty, but either producers still going or minor race
-                if (produced.load(std::memory_order_relaxed) >= actual_items) {
-                    // If producers are done and queue is empty, break
-                    if (q.empty())
-                        break;
+                // Two-phase termination: while producers run, a miss is
+                // just a race to back off from; once the last one has
+                // counted itself out, one final drain settles it.
+                if (producers_left.load(std::memory_order_acquire) == 0) {
+                    while (local_count < actual_items && q.dequeue(v))
+                        ++local_count;
+                    break;
                 }
-                std::this_thread::yield();
+                // Exponential in-core backoff; yield() traps into the
+                // scheduler, so save it for a saturated wait.
+                for (unsigned i = 0; i < backoff; ++i)
+                    cpu_relax();
+                if (backoff < 1024)
+                    backoff <<= 1;
+                else
+                    std::this_thread::yield();
             }
         }
+        consumed.v.store(local_count, std::memory_order_relaxed);
     };
 
-    auto t_start = clock_type::now();
-
-    // start consumer
-    std::thread consumer(consumer_fn);
-    // start producers
-    for (int p = 0; p < producers; ++p)
-        prod_threads.emplace_back(producer_fn, p);
+    // Warm up outside the timed window: the first enqueues pay for lazy
+    // page mapping, first-touch zeroing and allocator arena setup,
+    // which would otherwise be billed to the measured phase.
+    {
+        std::size_t warm = std::max<std::size_t>(1000, per_producer / 20);
+        int x = 0;
+        for (std::size_t i = 0; i < warm; ++i)
+            q.enqueue(static_cast<int>(i));
+        while (q.dequeue(x)) {
+        }
+    }
 
-    for (auto& t : prod_threads)
-        t.join();
-    consumer.join();
+    // Worker 0 (core 0) is the consumer, workers 1..P the producers;
+    // the pool releases them together right after t_start.
+    std::function<void(int)> job = [&](int id) {
+        if (id == 0)
+            consumer_fn();
+        else
+            producer_fn(id - 1);
+    };
 
+    auto t_start = clock_type::now();
+    pool.run(producers + 1, job);
     auto t_end = clock_type::now();
 
-    auto dur_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t_end - t_start).count();
-    double time_ms = static_cast<double>(dur_ns) / 1e6;
-    double time_s  = static_cast<double>(dur_ns) / 1e9;
+    double time_s  = std::chrono::duration<double>(t_end - t_start).count();
+    double time_ms = time_s * 1e3;
 
-    std::size_t enq = produced.load(std::memory_order_relaxed);
-    std::size_t deq = consumed.load(std::memory_order_relaxed);
+    std::size_t enq = produced.v.load(std::memory_order_relaxed);
+    std::size_t deq = consumed.v.load(std::memory_order_relaxed);
     std::size_t logical_ops = enq + deq;
 
     double throughput = (time_s > 0.0) ? (static_cast<double>(logical_ops) / time_s) : 0.0;
 
-    std::cout << "  time (ms)              : " << time_ms << "\n"
-              << "  enqueued               : " << enq << "\n"
-              << "  dequeued               : " << deq << "\n"
-              << "  logical ops (enq+deq)  : " << logical_ops << "\n"
-              << "  logical ops/sec        : " << throughput << "\n";
+    log << "  time (ms)              : " << time_ms << "\n"
+        << "  enqueued               : " << enq << "\n"
+        << "  dequeued               : " << deq << "\n"
+        << "  logical ops (enq+deq)  : " << logical_ops << "\n"
+        << "  logical ops/sec        : " << throughput << "\n";
 
     check(enq == actual_items, (name + " enq != actual_items").c_str());
     check(deq == actual_items, (name + " deq != actual_items").c_str());
@@ -206,6 +330,7 @@ BenchResult bench_queue_const_total(const std::string& name,
     res.actual_ops   = logical_ops;        // counting enq+deq as ops
     res.time_ms      = time_ms;
     res.ops_per_sec  = throughput;
+    res.log          = log.str();
     return res;
 }
 
@@ -220,14 +345,17 @@ void print_summary_header()
 
 void print_summary_line(const BenchResult& r)
 {
-    std::cout << r.kind << ","
-              << r.name << ","
-              << r.threads << ","
-              << r.requested_ops << ","
-              << r.actual_ops << ","
-              << std::fixed << std::setprecision(3) << r.time_ms << ","
-              << std::fixed << std::setprecision(0) << r.ops_per_sec
-              << "\n";
+    // One snprintf per row instead of iostream manipulators: fixed /
+    // setprecision mutate stream state and consult the locale per
+    // field. (std::format would be the C++20 spelling, but libstdc++ 12
+    // does not ship <format> yet.)
+    char buf[256];
+    int  len = std::snprintf(buf, sizeof(buf), "%s,%s,%d,%zu,%zu,%.3f,%.0f\n",
+                             r.kind.c_str(), r.name.c_str(), r.threads,
+                             r.requested_ops, r.actual_ops, r.time_ms,
+                             r.ops_per_sec);
+    if (len > 0)
+        std::fwrite(buf, 1, static_cast<std::size_t>(len), stdout);
 }
 
 // ---------------------------------------------------------------------------
@@ -284,19 +412,25 @@ int main(int argc, char** argv)
 
     std::vector<BenchResult> all_results;
 
+    // Workers are reused across every run; queues need producers+1 slots
+    int max_workers = 0;
+    for (int t : thread_counts)
+        max_workers = std::max(max_workers, t + 1);
+    WorkerPool pool(max_workers);
+
     // ------------------------
     // Stack benchmarks
     // ------------------------
     std::cout << "\n========== STACKS ==========\n";
     for (int t : thread_counts) {
         all_results.push_back(
-            bench_stack_const_total<SGLStack<int>>("SGLStack", t, total_stack_pushes));
+            bench_stack_const_total<SGLStack<int>>(pool, "SGLStack", t, total_stack_pushes));
         all_results.push_back(
-            bench_stack_const_total<TreiberStack<int>>("TreiberStack", t, total_stack_pushes));
+            bench_stack_const_total<TreiberStack<int>>(pool, "TreiberStack", t, total_stack_pushes));
         all_results.push_back(
-            bench_stack_const_total<EliminationStack<int>>("EliminationStack", t, total_stack_pushes));
+            bench_stack_const_total<EliminationStack<int>>(pool, "EliminationStack", t, total_stack_pushes));
         all_results.push_back(
-            bench_stack_const_total<FlatCombiningStack<int>>("FlatCombiningStack", t, total_stack_pushes));
+            bench_stack_const_total<FlatCombiningStack<int>>(pool, "FlatCombiningStack", t, total_stack_pushes));
     }
 
     // ------------------------
@@ -305,13 +439,19 @@ int main(int argc, char** argv)
     std::cout << "\n========== QUEUES ==========\n";
     for (int producers : thread_counts) {
         all_results.push_back(
-            bench_queue_const_total<SGLQueue<int>>("SGLQueue", producers, total_queue_items));
+            bench_queue_const_total<SGLQueue<int>>(pool, "SGLQueue", producers, total_queue_items));
         all_results.push_back(
-            bench_queue_const_total<MSQueue<int>>("MSQueue", producers, total_queue_items));
+            bench_queue_const_total<MSQueue<int>>(pool, "MSQueue", producers, total_queue_items));
         all_results.push_back(
-            bench_queue_const_total<FlatCombiningQueue<int>>("FlatCombiningQueue", producers, total_queue_items));
+            bench_queue_const_total<FlatCombiningQueue<int>>(pool, "FlatCombiningQueue", producers, total_queue_items));
     }
 
+    // ------------------------
+    // Per-run reports (deferred until all runs are finished)
+    // ------------------------
+    for (const auto& r : all_results)
+        std::cout << r.log;
+
     // ------------------------
     // Summary
     // ------------------------
@@ -43,12 +43,17 @@ void run_stack(const std::string& name, const Options& opt)
     const std::size_t total = opt.total_ops;
     const std::size_t per = total / th;
 
-    std::atomic<std::size_t> pushed{0};
-
-    auto worker = [&]() {
+    // No shared push counter: the total is th*per by construction, and a
+    // locked RMW per push on one cache line distorted every stack number.
+    // Values come from xorshift32: a linear ramp is perfectly
+    // predictable data that real workloads do not provide.
+    auto worker = [&](int id) {
+        std::uint32_t seed = 0x9E3779B9u ^ static_cast<std::uint32_t>(id);
         for (std::size_t i = 0; i < per; ++i) {
-            st.push((int)i);
-            pushed.fetch_add(1, std::memory_order_relaxed);
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            st.push(static_cast<int>(seed));
         }
     };
 
@@ -56,7 +61,7 @@ void run_stack(const std::string& name, const Options& opt)
     threads.reserve(th);
 
     auto t0 = clock::now();
-    for (int i = 0; i < th; ++i) threads.emplace_back(worker);
+    for (int i = 0; i < th; ++i) threads.emplace_back(worker, i);
     for (auto& t : threads) t.join();
     auto t1 = clock::now();
 
@@ -69,7 +74,7 @@ void run_stack(const std::string& name, const Options& opt)
     std::cout << "=== STACK RUN ===\n";
     std::cout << "algo=" << name << "\n";
     std::cout << "threads=" << th << "\n";
-    std::cout << "pushed=" << pushed << "\n";
+    std::cout << "pushed=" << (per * th) << "\n";
     std::cout << "popped=" << popcnt << "\n";
     std::cout << "time_ms=" << ms << "\n";
     std::cout << "==========\n";
@@ -87,38 +92,61 @@ void run_queue(const std::string& name, const Options& opt)
     const std::size_t total = opt.total_ops;
     const std::size_t per = total / prod;
 
-    std::atomic<std::size_t> produced{0};
-    std::atomic<std::size_t> consumed{0};
+    // No shared produced counter: the total is prod*per by construction,
+    // and termination runs off producers_done. `consumed` is only
+    // written once, at consumer exit.
+    Padded<std::size_t> consumed{0};
+    std::atomic<bool>   producers_done{false};
 
-    auto p = [&]() {
+    auto p = [&](int id) {
+        std::uint32_t seed = 0x9E3779B9u ^ static_cast<std::uint32_t>(id);
         for (std::size_t i = 0; i < per; ++i) {
-            q.enqueue((int)i);
-            produced.fetch_add(1, std::memory_order_relaxed);
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            q.enqueue(static_cast<int>(seed));
         }
     };
 
     auto c = [&]() {
         int x;
+        std::size_t local_consumed = 0;
+        unsigned    backoff        = 1;
         while (true) {
             if (q.dequeue(x)) {
-                consumed.fetch_add(1, std::memory_order_relaxed);
+                // Local count; per-dequeue fetch_add on `consumed` was an
+                // RMW on a shared line in the middle of the hot path.
+                ++local_consumed;
+                backoff = 1;
                 continue;
             }
-            if (produced.load() >= total) {
-                while (q.dequeue(x)) consumed++;
+            // Two-phase termination: while producers run, a miss is
+            // just a race to back off from; once they are done (and
+            // joined), one final drain settles it.
+            if (producers_done.load(std::memory_order_acquire)) {
+                while (q.dequeue(x)) ++local_consumed;
                 break;
             }
-            std::this_thread::yield();
+            // Exponential in-core backoff; yield() traps into the
+            // scheduler, so save it for a saturated wait.
+            for (unsigned i = 0; i < backoff; ++i)
+                cpu_relax();
+            if (backoff < 1024)
+                backoff <<= 1;
+            else
+                std::this_thread::yield();
         }
+        consumed.v.store(local_consumed, std::memory_order_relaxed);
     };
 
     std::vector<std::thread> threads;
     threads.reserve(prod);
 
     auto t0 = clock::now();
-    for (int i = 0; i < prod; ++i) threads.emplace_back(p);
+    for (int i = 0; i < prod; ++i) threads.emplace_back(p, i);
     std::thread consumer(c);
     for (auto& t : threads) t.join();
+    producers_done.store(true, std::memory_order_release);
     consumer.join();
     auto t1 = clock::now();
 
@@ -127,8 +155,8 @@ void run_queue(const std::string& name, const Options& opt)
     std::cout << "=== QUEUE RUN ===\n";
     std::cout << "algo=" << name << "\n";
     std::cout << "producers=" << prod << "\n";
-    std::cout << "produced=" << produced << "\n";
-    std::cout << "consumed=" << consumed << "\n";
+    std::cout << "produced=" << (per * prod) << "\n";
+    std::cout << "consumed=" << consumed.v << "\n";
     std::cout << "time_ms=" << ms << "\n";
     std::cout << "==========\n";
 }
@@ -30,7 +30,7 @@ static void test_single_waiter()
     std::mutex   m;
 
     const int rounds = 10;   // small & fast
-    int        wake_count = 0;
+    std::atomic<int> wake_count{0};
 
     std::atomic<bool> ready{false};
 
@@ -51,18 +51,22 @@ static void test_single_waiter()
         std::this_thread::yield();
     }
 
-    // Give worker a moment to actually enter wait() the first time
-    std::this_thread::sleep_for(5ms);
-
     // Main thread: do 'rounds' notify_one() calls
     for (int i = 0; i < rounds; ++i) {
+        // Not an empty lock: CVNoSpurious waiters record the generation
+        // while holding m, so acquiring m proves the worker has released
+        // it into wait() and will see this bump. Without it a notify can
+        // land between two waits and deadlock the round.
         {
             std::lock_guard<std::mutex> lk(m);
-            // In a real program you would update shared state here.
         }
         std::cout << "  [main] notify_one #" << (i + 1) << "\n";
         cv.notify_one();
-        std::this_thread::sleep_for(2ms); // small pause for visibility
+        // Spin until the wake lands instead of sleeping a fixed 2ms:
+        // the round trip is microseconds, the sleep was the test's cost.
+        while (wake_count.load(std::memory_order_acquire) < i + 1) {
+            std::this_thread::yield();
+        }
     }
 
     worker.join();
@@ -90,7 +94,7 @@ static void test_broadcast_many_waiters()
     const int threads = 3;   // small
     const int rounds  = 5;   // small
 
-    std::vector<int> wakes(threads, 0);
+    std::vector<std::atomic<int>> wakes(threads);
     std::atomic<int> ready{0};
 
     std::vector<std::thread> workers;
@@ -116,17 +120,27 @@ static void test_broadcast_many_waiters()
         std::this_thread::yield();
     }
 
-    // Give them a brief moment to enter the first wait()
-    std::this_thread::sleep_for(5ms);
+    auto total_wakes = [&] {
+        int sum = 0;
+        for (auto& w : wakes)
+            sum += w.load(std::memory_order_acquire);
+        return sum;
+    };
 
     for (int r = 0; r < rounds; ++r) {
+        // Not an empty lock: acquiring m proves every waiter that bumped
+        // its counter has re-entered wait() and recorded the current
+        // generation, so this broadcast cannot be lost.
         {
             std::lock_guard<std::mutex> lk(m);
-            // In real code, update condition here.
         }
         std::cout << "  [main] notify_all #" << (r + 1) << "\n";
         cv.notify_all();
-        std::this_thread::sleep_for(5ms);
+        // Spin until every waiter reports the wake instead of sleeping
+        // a fixed 5ms per round.
+        while (total_wakes() < threads * (r + 1)) {
+            std::this_thread::yield();
+        }
     }
 
     for (auto& t : workers) {
@@ -29,6 +29,20 @@ int main()
         check(!q.dequeue(x), "FC Queue empty dequeue");
     }
 
+    // ---- Test FlatCombiningQueue bulk API ----
+    {
+        FlatCombiningQueue<int> q;
+        int in[4] = {1, 2, 3, 4};
+        q.bulk_enqueue(in, 4);
+
+        int out[8] = {};
+        std::size_t got = q.bulk_dequeue(out, 8);
+        check(got == 4, "FC Queue bulk dequeue count");
+        for (int i = 0; i < 4; ++i)
+            check(out[i] == i + 1, "FC Queue bulk FIFO order");
+        check(q.bulk_dequeue(out, 8) == 0, "FC Queue bulk empty dequeue");
+    }
+
     std::cout << "test_flat_combining OK\n";
     return 0;
 }
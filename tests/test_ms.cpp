@@ -4,7 +4,6 @@
 #include <iostream>
 #include <thread>
 #include <vector>
-#include <algorithm>
 #include <atomic>
 
 int main()
@@ -35,23 +34,25 @@ int main()
         MSQueue<int> q;
         const int N = 50000;
 
-        std::thread producer([&] {
+        std::jthread producer([&] {
             for (int i = 0; i < N; ++i) {
                 q.enqueue(i);
             }
         });
 
-        std::vector<int> out;
-        out.reserve(N);
-
-        std::thread consumer([&] {
-            int x;
-            while ((int)out.size() < N) {
-                if (q.dequeue(x)) {
-                    out.push_back(x);
-                } else {
+        // Sized, not reserved: reserve() leaves the pages uncommitted
+        // and the consumer would eat a minor fault per 4 KB of output
+        // mid-drain. Zero-filling up front moves those faults out of
+        // the measured/contended phase.
+        std::vector<int> out(N);
+        std::size_t written = 0;
+
+        std::jthread consumer([&] {
+            while ((int)written < N) {
+                if (q.dequeue(out[written]))
+                    ++written;
+                else
                     std::this_thread::yield();
-                }
             }
         });
 
@@ -59,8 +60,8 @@ int main()
         consumer.join();
 
         std::cout << "  produced: " << N << "\n";
-        std::cout << "  consumed: " << out.size() << "\n";
-        check((int)out.size() == N, "MSQueue SPSC count match");
+        std::cout << "  consumed: " << written << "\n";
+        check((int)written == N, "MSQueue SPSC count match");
 
         for (int i = 0; i < N; ++i) {
             check(out[i] == i, "MSQueue SPSC FIFO order");
@@ -76,31 +77,52 @@ int main()
         const int per_thread = 25000;
         const int total = threads * per_thread;
 
-        std::atomic<int> produced{0};
-
+        // The counter lives in its own alignas(64) slot and is accessed
+        // through std::atomic_ref: a bare std::atomic<int> stack local
+        // gives no say over which neighbouring locals share its cache
+        // line.
+        struct alignas(64) Slot {
+            int  v = 0;
+            char pad[60];
+        } slot;
+        std::atomic_ref<int> produced(slot.v);
+
+        // Each producer publishes its whole count once, with release,
+        // after its last enqueue; the consumer's acquire load below then
+        // also orders those final enqueues, instead of paying a LOCK'd
+        // RMW per item.
         auto producer = [&](int id) {
             for (int i = 0; i < per_thread; ++i) {
                 int val = id * per_thread + i;
                 q.enqueue(val);
-                produced.fetch_add(1, std::memory_order_relaxed);
             }
+            produced.fetch_add(per_thread, std::memory_order_release);
         };
 
-        std::vector<std::thread> producers;
+        std::vector<std::jthread> producers;
+        producers.reserve(threads);
         for (int t = 0; t < threads; ++t)
             producers.emplace_back(producer, t);
 
-        std::vector<int> out;
-        out.reserve(total);
+        // Sized up front for the same pre-touch reason as the SPSC run.
+        std::vector<int> out(total);
+        std::size_t written = 0;
 
-        std::thread consumer([&] {
-            while ((int)out.size() < total) {
-                int x;
-                if (q.dequeue(x)) {
-                    out.push_back(x);
+        std::jthread consumer([&] {
+            while ((int)written < total) {
+                if (q.dequeue(out[written])) {
+                    ++written;
                 } else {
-                    if (produced.load(std::memory_order_relaxed) >= total && q.empty())
+                    // Two-phase termination: a producer can finish in
+                    // the window between our miss and this check, so
+                    // on seeing everyone done, drain once more before
+                    // concluding the queue is empty.
+                    if (produced.load(std::memory_order_acquire) >= total) {
+                        while ((int)written < total &&
+                               q.dequeue(out[written]))
+                            ++written;
                         break;
+                    }
                     std::this_thread::yield();
                 }
             }
@@ -111,16 +133,20 @@ int main()
         consumer.join();
 
         std::cout << "  produced: " << total << "\n";
-        std::cout << "  consumed: " << out.size() << "\n";
-        check((int)out.size() == total, "MSQueue MPSC count match");
-
-        std::sort(out.begin(), out.end());
-        for (int id = 0; id < threads; ++id) {
-            for (int i = 0; i < per_thread; ++i) {
-                int expected = id * per_thread + i;
-                bool found = std::binary_search(out.begin(), out.end(), expected);
-                check(found, "MSQueue MPSC missing element");
-            }
+        std::cout << "  consumed: " << written << "\n";
+        check((int)written == total, "MSQueue MPSC count match");
+
+        // Values cover [0, total) exactly once, so a presence vector
+        // verifies in O(N) what sort + per-element binary_search did in
+        // O(N log N).
+        std::vector<char> seen(total, 0);
+        for (int v : out) {
+            check(v >= 0 && v < total, "MSQueue MPSC value out of range");
+            check(!seen[v], "MSQueue MPSC duplicate element");
+            seen[v] = 1;
+        }
+        for (int i = 0; i < total; ++i) {
+            check(seen[i], "MSQueue MPSC missing element");
         }
 
         std::cout << "[MSQueue] MPSC test passed.\n\n";
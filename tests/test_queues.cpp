@@ -4,17 +4,49 @@
 #include "flat_combining_queue.h"
 
 #include <iostream>
+#include <sstream>
 #include <thread>
 #include <vector>
-#include <algorithm>
 #include <string>
 #include <atomic>
+#include <cstdint>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// XOR-fold a buffer of ints. With AVX2 the reduction runs 8 lanes
+// wide; the scalar tail (and the non-AVX2 build) fold one at a time.
+static std::uint32_t xor_fold(const int* p, std::size_t n)
+{
+    std::size_t   i   = 0;
+    std::uint32_t acc = 0;
+#ifdef __AVX2__
+    __m256i vacc = _mm256_setzero_si256();
+    for (; i + 8 <= n; i += 8) {
+        vacc = _mm256_xor_si256(
+            vacc,
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)));
+    }
+    alignas(32) std::uint32_t lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), vacc);
+    for (std::uint32_t lane : lanes)
+        acc ^= lane;
+#endif
+    for (; i < n; ++i)
+        acc ^= static_cast<std::uint32_t>(p[i]);
+    return acc;
+}
 
 // Single-thread FIFO check
 template <typename Queue>
 void single_thread_queue_check(const std::string& name)
 {
-    std::cout << "[Single-thread] Testing " << name << "...\n";
+    // Buffer the section's output and emit it in one write at the end:
+    // every operator<< on cout locks the stream and can sync with
+    // stdio.
+    std::ostringstream log;
+    log << "[Single-thread] Testing " << name << "...\n";
 
     Queue q;
     const int N = 5;
@@ -25,102 +57,238 @@ void single_thread_queue_check(const std::string& name)
     int x;
     for (int i = 1; i <= N; ++i) {
         bool ok = q.dequeue(x);
-        check(ok, (name + " single-thread: dequeue should succeed").c_str());
-        check(x == i, (name + " single-thread: FIFO violated").c_str());
+        check(ok, [&] { return name + " single-thread: dequeue should succeed"; });
+        check(x == i, [&] { return name + " single-thread: FIFO violated"; });
     }
 
     bool ok = q.dequeue(x);
-    check(!ok, (name + " single-thread: extra dequeue should fail").c_str());
+    check(!ok, [&] { return name + " single-thread: extra dequeue should fail"; });
 
-    std::cout << "  -> " << name << " single-thread OK\n\n";
+    log << "  -> " << name << " single-thread OK\n\n";
+    std::cout << log.str();
 }
 
 // Multi-producer / single-consumer identical pattern for all queues
 template <typename Queue>
-void mpsc_queue_check(const std::string& name,
+void mpsc_queue_check(WorkerPool& pool,
+                      const std::string& name,
                       int producers,
                       int per_thread)
 {
-    std::cout << "[Multi-producer/Single-consumer] Testing " << name
-              << " with " << producers << " producers, "
-              << per_thread << " items each...\n";
+    // Buffered like the single-thread check; nothing touches cout
+    // while the pool workers run.
+    std::ostringstream log;
+    log << "[Multi-producer/Single-consumer] Testing " << name
+        << " with " << producers << " producers, "
+        << per_thread << " items each...\n";
 
     Queue q;
     const int total = producers * per_thread;
-    std::atomic<int> produced{0};
+
+    // One padded counter per producer: a single shared counter would be
+    // fetch_add'ed on every enqueue and ping-pong its cache line across
+    // all producers. Each producer instead publishes its count once,
+    // with release, after its last enqueue.
+    std::vector<Padded<int>> produced(producers);
+
+    // Each producer also records what it enqueued in its own shadow
+    // vector — purely local, zero contention — so verification checks
+    // the drain against what actually went in rather than assuming the
+    // value scheme. The queue stays the only shared structure.
+    std::vector<std::vector<int>> shadow(producers);
 
     auto producer = [&](int id) {
+        shadow[id].reserve(per_thread);
+        // Per-producer xorshift32 drives a tiny random gap between
+        // enqueues: back-to-back producers settle into a lockstep
+        // cadence the branch predictor learns, which understates
+        // real-world burstiness.
+        std::uint32_t rng = 0x9E3779B9u ^ static_cast<std::uint32_t>(id);
         for (int i = 0; i < per_thread; ++i) {
             int val = id * per_thread + i;
+            shadow[id].push_back(val);
             q.enqueue(val);
-            produced.fetch_add(1, std::memory_order_relaxed);
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+            for (std::uint32_t k = 0; k < (rng & 7u); ++k)
+                cpu_relax();
         }
+        produced[id].v.store(per_thread, std::memory_order_release);
     };
 
-    std::vector<std::thread> prod_threads;
-    for (int p = 0; p < producers; ++p)
-        prod_threads.emplace_back(producer, p);
+    auto all_produced = [&] {
+        for (int p = 0; p < producers; ++p) {
+            if (produced[p].v.load(std::memory_order_acquire) < per_thread)
+                return false;
+        }
+        return true;
+    };
 
-    std::vector<int> out;
-    out.reserve(total);
+    // Fixed-capacity array: total is known up front, and a raw slab
+    // keeps the consumer's store a plain indexed write with no
+    // capacity branch. Value-init zero-fills, which also commits the
+    // pages before the threads start.
+    auto out = std::make_unique<int[]>(total);
+    std::size_t written = 0;
 
-    std::thread consumer([&] {
-        while ((int)out.size() < total) {
-            int x;
-            if (q.dequeue(x)) {
-                out.push_back(x);
+    // SPSC handoff from consumer to verifier: out[] itself is the
+    // channel — the consumer appends in order and publishes its write
+    // index through written_pub; the verifier trails the index,
+    // range-checking, duplicate-marking and XOR-folding values while
+    // the drain is still running, instead of serially after it.
+    Padded<std::size_t>       written_pub{0};
+    std::atomic<bool>         drain_done{false};
+    std::vector<std::uint8_t> seen(total, 0);
+    std::uint32_t             out_fold = 0;
+
+    auto consumer = [&] {
+        int spins = 0;
+        while ((int)written < total) {
+            // Batched drain: one lock acquisition / guard entry /
+            // combining round covers up to 64 items.
+            std::size_t n = q.bulk_dequeue(
+                out.get() + written,
+                std::min<std::size_t>(64, total - written));
+            if (n != 0) {
+                written += n;
+                written_pub.v.store(written, std::memory_order_release);
             } else {
-                // if all produced and queue seems empty, let it exit
-                if (produced.load(std::memory_order_relaxed) >= total && q.empty())
+                // Two-phase termination as in the bench: a producer
+                // can finish between our miss and the count check, so
+                // seeing everyone done only means no *new* items are
+                // coming — one final drain settles what landed in the
+                // window, and only then is an empty queue conclusive.
+                if (all_produced()) {
+                    std::size_t n;
+                    while (written < (std::size_t)total &&
+                           (n = q.bulk_dequeue(
+                                out.get() + written,
+                                std::min<std::size_t>(
+                                    64, total - written))) != 0) {
+                        written += n;
+                        written_pub.v.store(written,
+                                            std::memory_order_release);
+                    }
                     break;
-                std::this_thread::yield();
+                }
+                // Short in-core spin first; yield() is a syscall, so
+                // only fall back to it every few misses.
+                for (int k = 0; k < 40; ++k)
+                    cpu_relax();
+                if (++spins % 10 == 0)
+                    std::this_thread::yield();
             }
         }
+        drain_done.store(true, std::memory_order_release);
+    };
+
+    // Only the verifier touches seen[] and out_fold while the pool
+    // runs, so both stay plain; the pool's done barrier publishes them
+    // to the checks below.
+    auto verifier = [&] {
+        std::size_t done  = 0;
+        int         spins = 0;
+        for (;;) {
+            std::size_t w = written_pub.v.load(std::memory_order_acquire);
+            if (w == done) {
+                if (drain_done.load(std::memory_order_acquire) &&
+                    written_pub.v.load(std::memory_order_acquire) == done)
+                    break;
+                for (int k = 0; k < 40; ++k)
+                    cpu_relax();
+                if (++spins % 10 == 0)
+                    std::this_thread::yield();
+                continue;
+            }
+            for (; done < w; ++done) {
+                int v = out[done];
+                check(v >= 0 && v < total,
+                      [&] { return name + " MPSC: value out of range"; });
+                check(!seen[v],
+                      [&] { return name + " MPSC: duplicate value"; });
+                seen[v] = 1;
+                out_fold ^= static_cast<std::uint32_t>(v);
+            }
+        }
+    };
+
+    // Pool worker 0 (pinned to core 0) consumes, worker 1 runs the
+    // trailing verifier, workers 2..producers+1 produce.
+    pool.run(producers + 2, [&](int id) {
+        if (id == 0)
+            consumer();
+        else if (id == 1)
+            verifier();
+        else
+            producer(id - 2);
     });
 
-    for (auto& t : prod_threads)
-        t.join();
-    consumer.join();
+    log << "  produced: " << total << "\n";
+    log << "  consumed: " << written << "\n";
 
-    std::cout << "  produced: " << total << "\n";
-    std::cout << "  consumed: " << out.size() << "\n";
+    check((int)written == total, [&] { return name + " MPSC: count mismatch"; });
 
-    check((int)out.size() == total,
-          (name + " MPSC: count mismatch").c_str());
+    // Fast pre-check: the drain must XOR to the same value as the
+    // union of the producer shadows. Catches most corruption before
+    // the byte-per-value scan below.
+    std::uint32_t want_fold = 0;
+    for (const auto& sh : shadow)
+        want_fold ^= xor_fold(sh.data(), sh.size());
+    check(out_fold == want_fold,
+          [&] { return name + " MPSC: XOR fold mismatch"; });
 
-    std::sort(out.begin(), out.end());
-    for (int id = 0; id < producers; ++id) {
-        for (int i = 0; i < per_thread; ++i) {
-            int expected = id * per_thread + i;
-            bool found = std::binary_search(out.begin(), out.end(), expected);
-            check(found,
-                  (name + " MPSC: missing value " +
-                   std::to_string(expected)).c_str());
+    // The verifier already range-checked and duplicate-marked the
+    // drain; what remains is the shadow side — every shadowed value
+    // must have come back out and nothing else. The scans are pure CPU
+    // work with independent iterations, so the pool shards them into
+    // contiguous blocks; each pool.run() is a barrier, ordering the
+    // expected[] marking before its readers.
+    std::vector<std::uint8_t> expected(total, 0);
+    const int shards = pool.size();
+
+    pool.run(shards, [&](int s) {
+        if (s < producers)
+            for (int v : shadow[s])  // disjoint ranges: no two shards race
+                expected[v] = 1;
+    });
+
+    pool.run(shards, [&](int s) {
+        const int lo = total * s / shards;
+        const int hi = total * (s + 1) / shards;
+        for (int i = lo; i < hi; ++i) {
+            check(seen[i] == expected[i],
+                  [&] { return name + " MPSC: missing value " +
+                               std::to_string(i); });
         }
-    }
+    });
 
-    std::cout << "  -> " << name << " MPSC test OK\n\n";
-}
-bool empty() const {
-    std::lock_guard<std::mutex> lk(combine_m_);
-    return data_.empty();
+    log << "  -> " << name << " MPSC test OK\n\n";
+    std::cout << log.str();
 }
 int main()
 {
+    std::ios::sync_with_stdio(false);
+
     std::cout << "===== Unified Queue Test (SGLQueue, MSQueue, FlatCombiningQueue) =====\n\n";
 
     const int producers = 4;
     const int per_thread = 25000;
 
+    // One pool for all three MPSC runs: worker 0 is the consumer and
+    // worker 1 the trailing verifier, so the pool holds producers + 2
+    // threads.
+    WorkerPool pool(producers + 2);
+
     // 1) Single-thread FIFO correctness
     single_thread_queue_check<SGLQueue<int>>("SGLQueue");
     single_thread_queue_check<MSQueue<int>>("MSQueue");
     single_thread_queue_check<FlatCombiningQueue<int>>("FlatCombiningQueue");
 
     // 2) Multi-producer single-consumer identical workload
-    mpsc_queue_check<SGLQueue<int>>("SGLQueue", producers, per_thread);
-    mpsc_queue_check<MSQueue<int>>("MSQueue", producers, per_thread);
-    mpsc_queue_check<FlatCombiningQueue<int>>("FlatCombiningQueue", producers, per_thread);
+    mpsc_queue_check<SGLQueue<int>>(pool, "SGLQueue", producers, per_thread);
+    mpsc_queue_check<MSQueue<int>>(pool, "MSQueue", producers, per_thread);
+    mpsc_queue_check<FlatCombiningQueue<int>>(pool, "FlatCombiningQueue", producers, per_thread);
 
     std::cout << "===== test_queues OK =====\n";
     return 0;
@@ -62,7 +62,8 @@ int main()
             }
         };
 
-        std::vector<std::thread> ts;
+        std::vector<std::jthread> ts;
+        ts.reserve(threads);
         for (int t = 0; t < threads; ++t)
             ts.emplace_back(worker, t);
         for (auto& th : ts)
@@ -5,16 +5,21 @@
 #include "flat_combining_stack.h"
 
 #include <iostream>
+#include <sstream>
 #include <thread>
 #include <vector>
-#include <algorithm>
 #include <string>
+#include <cstdint>
 
 // Single-thread basic LIFO correctness
 template <typename Stack>
 void single_thread_stack_check(const std::string& name)
 {
-    std::cout << "[Single-thread] Testing " << name << "...\n";
+    // Buffer the section's output and emit it in one write at the end:
+    // every operator<< on cout locks the stream and can sync with
+    // stdio.
+    std::ostringstream log;
+    log << "[Single-thread] Testing " << name << "...\n";
 
     Stack st;
     const int N = 5;
@@ -25,91 +30,133 @@ void single_thread_stack_check(const std::string& name)
     int x;
     for (int i = N; i >= 1; --i) {
         bool ok = st.pop(x);
-        check(ok, (name + " single-thread: pop should succeed").c_str());
-        check(x == i, (name + " single-thread: LIFO violated").c_str());
+        check(ok, [&] { return name + " single-thread: pop should succeed"; });
+        check(x == i, [&] { return name + " single-thread: LIFO violated"; });
     }
 
     bool ok = st.pop(x);
-    check(!ok, (name + " single-thread: extra pop should fail").c_str());
+    check(!ok, [&] { return name + " single-thread: extra pop should fail"; });
 
-    std::cout << "  -> " << name << " single-thread OK\n\n";
+    log << "  -> " << name << " single-thread OK\n\n";
+    std::cout << log.str();
 }
 
 // Multi-thread push, single-thread pop, identical for all stacks
 template <typename Stack>
-void multi_thread_stack_check(const std::string& name,
+void multi_thread_stack_check(WorkerPool& pool,
+                              const std::string& name,
                               int threads,
                               int pushes_per_thread)
 {
-    std::cout << "[Multi-thread] Testing " << name
-              << " with " << threads << " threads, "
-              << pushes_per_thread << " pushes per thread...\n";
+    // Buffered like the single-thread check; nothing touches cout
+    // while the pool workers run.
+    std::ostringstream log;
+    log << "[Multi-thread] Testing " << name
+        << " with " << threads << " threads, "
+        << pushes_per_thread << " pushes per thread...\n";
 
     Stack st;
     const int total_pushes = threads * pushes_per_thread;
 
     auto worker = [&](int id) {
+        // Random 0..7 PAUSE gap between pushes, for the same
+        // burstiness reason as the queue producers.
+        std::uint32_t rng = 0x9E3779B9u ^ static_cast<std::uint32_t>(id);
         for (int i = 0; i < pushes_per_thread; ++i) {
             int val = id * pushes_per_thread + i;   // disjoint ranges
             st.push(val);
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+            for (std::uint32_t k = 0; k < (rng & 7u); ++k)
+                cpu_relax();
         }
     };
 
-    std::vector<std::thread> ts;
-    for (int t = 0; t < threads; ++t)
-        ts.emplace_back(worker, t);
-    for (auto& th : ts)
-        th.join();
+    pool.run(threads, worker);
 
-    std::cout << "  All pushes done. Popping...\n";
+    log << "  All pushes done. Popping...\n";
 
-    std::vector<int> popped;
-    popped.reserve(total_pushes);
+    // Fixed-capacity array: the total is known, so the drain is a
+    // plain indexed store with no capacity branch. Values past the
+    // expected count are dropped; the count check below still trips.
+    auto popped   = std::make_unique<int[]>(total_pushes);
+    std::size_t   popped_n = 0;
     int x;
 
     while (st.pop(x)) {
-        popped.push_back(x);
+        if (popped_n < (std::size_t)total_pushes)
+            popped[popped_n] = x;
+        ++popped_n;
     }
 
-    std::cout << "  pushed total: " << total_pushes << "\n";
-    std::cout << "  popped total: " << popped.size() << "\n";
-
-    check((int)popped.size() == total_pushes,
-          (name + " multi-thread: count mismatch").c_str());
-
-    std::sort(popped.begin(), popped.end());
-
-    for (int id = 0; id < threads; ++id) {
-        for (int i = 0; i < pushes_per_thread; ++i) {
-            int expected = id * pushes_per_thread + i;
-            bool found = std::binary_search(popped.begin(), popped.end(), expected);
-            check(found,
-                  (name + " multi-thread: missing value " +
-                   std::to_string(expected)).c_str());
+    log << "  pushed total: " << total_pushes << "\n";
+    log << "  popped total: " << popped_n << "\n";
+
+    check((int)popped_n == total_pushes,
+          [&] { return name + " multi-thread: count mismatch"; });
+
+    // Values cover [0, total_pushes) exactly once, so a presence vector
+    // does in O(N) what sort + per-value binary_search did in O(N log N).
+    // The scans have independent iterations, so the pool shards them
+    // into contiguous blocks; duplicate detection goes through
+    // atomic_ref so two shards that popped the same value cannot both
+    // see it fresh.
+    std::vector<std::uint8_t> seen(total_pushes, 0);
+    const int shards = pool.size();
+
+    pool.run(shards, [&](int s) {
+        const std::size_t lo = popped_n * s / shards;
+        const std::size_t hi = popped_n * (s + 1) / shards;
+        for (std::size_t k = lo; k < hi; ++k) {
+            int v = popped[k];
+            check(v >= 0 && v < total_pushes,
+                  [&] { return name + " multi-thread: value out of range"; });
+            std::atomic_ref<std::uint8_t> cell(seen[v]);
+            check(cell.exchange(1, std::memory_order_relaxed) == 0,
+                  [&] { return name + " multi-thread: duplicate value"; });
         }
-    }
+    });
+
+    pool.run(shards, [&](int s) {
+        const int lo = total_pushes * s / shards;
+        const int hi = total_pushes * (s + 1) / shards;
+        for (int i = lo; i < hi; ++i) {
+            check(seen[i],
+                  [&] { return name + " multi-thread: missing value " + std::to_string(i); });
+        }
+    });
 
-    std::cout << "  -> " << name << " multi-thread OK\n\n";
+    log << "  -> " << name << " multi-thread OK\n\n";
+    std::cout << log.str();
 }
 
 int main()
 {
+    std::ios::sync_with_stdio(false);
+
     std::cout << "===== Unified Stack Test (SGL, Treiber, Elimination, FlatCombining) =====\n\n";
 
     const int threads = 4;
     const int pushes_per_thread = 20000;
 
+    // One pool reused by all four multi-thread sections, instead of
+    // spawning and joining four fresh threads per stack type.
+    WorkerPool pool(threads);
+
     // 1) Single-thread correctness for each
     single_thread_stack_check<SGLStack<int>>("SGLStack");
     single_thread_stack_check<TreiberStack<int>>("TreiberStack");
+    single_thread_stack_check<TreiberStack<int, NoBackoff>>("TreiberStack(NoBackoff)");
     single_thread_stack_check<EliminationStack<int>>("EliminationStack");
     single_thread_stack_check<FlatCombiningStack<int>>("FlatCombiningStack");
 
     // 2) Multi-thread identical workload for each
-    multi_thread_stack_check<SGLStack<int>>("SGLStack", threads, pushes_per_thread);
-    multi_thread_stack_check<TreiberStack<int>>("TreiberStack", threads, pushes_per_thread);
-    multi_thread_stack_check<EliminationStack<int>>("EliminationStack", threads, pushes_per_thread);
-    multi_thread_stack_check<FlatCombiningStack<int>>("FlatCombiningStack", threads, pushes_per_thread);
+    multi_thread_stack_check<SGLStack<int>>(pool, "SGLStack", threads, pushes_per_thread);
+    multi_thread_stack_check<TreiberStack<int>>(pool, "TreiberStack", threads, pushes_per_thread);
+    multi_thread_stack_check<TreiberStack<int, NoBackoff>>(pool, "TreiberStack(NoBackoff)", threads, pushes_per_thread);
+    multi_thread_stack_check<EliminationStack<int>>(pool, "EliminationStack", threads, pushes_per_thread);
+    multi_thread_stack_check<FlatCombiningStack<int>>(pool, "FlatCombiningStack", threads, pushes_per_thread);
 
     std::cout << "===== test_stacks OK =====\n";
     return 0;
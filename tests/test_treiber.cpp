@@ -1,12 +1,79 @@
 #include "treiber_stack.h"
+#include "hazard_pointers.h"
 #include "common.h"
 
 #include <iostream>
 #include <thread>
 #include <vector>
-#include <algorithm>
 #include <cstdint>
 
+// Minimal Treiber stack protected by hazard pointers instead of EBR.
+// The shipped containers all moved to epochs; this variant exists so
+// hazard_pointers.h — the slot cache, the hashed hazard set in scan()
+// and the templated deleter — stays under multi-threaded test.
+template <typename T>
+class HPTreiberStack {
+private:
+    struct Node {
+        T     value;
+        Node* next;
+        explicit Node(const T& v) : value(v), next(nullptr) {}
+    };
+
+    std::atomic<Node*> head_{nullptr};
+
+public:
+    HPTreiberStack() = default;
+
+    ~HPTreiberStack()
+    {
+        Node* n = head_.load(std::memory_order_relaxed);
+        while (n) {
+            Node* next = n->next;
+            delete n;
+            n = next;
+        }
+    }
+
+    void push(const T& value)
+    {
+        Node* new_node = new Node(value);
+        Node* old_head = head_.load(std::memory_order_relaxed);
+        do {
+            new_node->next = old_head;
+        } while (!head_.compare_exchange_weak(
+            old_head,
+            new_node,
+            std::memory_order_release,
+            std::memory_order_relaxed));
+    }
+
+    bool pop(T& out)
+    {
+        hp::HazardPointerOwner hazard;
+        for (;;) {
+            Node* h = head_.load(std::memory_order_acquire);
+            if (!h)
+                return false;
+            // Publish the hazard, then re-read head_: if it moved, the
+            // published node may already be retired and h->next below
+            // would be a use-after-free.
+            hazard.set(h);
+            if (head_.load(std::memory_order_acquire) != h)
+                continue;
+            if (head_.compare_exchange_weak(h,
+                                            h->next,
+                                            std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+                hazard.clear();
+                out = std::move(h->value);
+                hp::retired_list<Node>().retire(h);
+                return true;
+            }
+        }
+    }
+};
+
 int main()
 {
     std::cout << "===== test_treiber: Lock-free TreiberStack =====\n\n";
@@ -45,7 +112,8 @@ int main()
             }
         };
 
-        std::vector<std::thread> ts;
+        std::vector<std::jthread> ts;
+        ts.reserve(threads);
         for (int t = 0; t < threads; ++t)
             ts.emplace_back(worker, t);
         for (auto& th : ts)
@@ -65,18 +133,75 @@ int main()
 
         check((int)popped.size() == total_pushes, "TreiberStack multi-thread count match");
 
-        std::sort(popped.begin(), popped.end());
+        // Keys are (id << 32) | i, so indexing a presence vector by
+        // id*pushes_per_thread+i replaces the O(N log N) sort plus a
+        // binary_search per key with two linear passes.
+        std::vector<std::uint8_t> seen(total_pushes, 0);
+        for (std::uint64_t v : popped) {
+            int id = static_cast<int>(v >> 32);
+            int i  = static_cast<int>(v & 0xFFFFFFFFu);
+            check(id >= 0 && id < threads && i >= 0 && i < pushes_per_thread,
+                  "TreiberStack value out of range in multi-thread test");
+            std::size_t idx = static_cast<std::size_t>(id) * pushes_per_thread + i;
+            check(!seen[idx], "TreiberStack duplicate element in multi-thread test");
+            seen[idx] = 1;
+        }
+        for (int i = 0; i < total_pushes; ++i) {
+            check(seen[i], "TreiberStack missing element in multi-thread test");
+        }
 
-        for (int id = 0; id < threads; ++id) {
-            for (int i = 0; i < pushes_per_thread; ++i) {
-                std::uint64_t expected =
-                    (static_cast<std::uint64_t>(id) << 32) | static_cast<std::uint32_t>(i);
-                bool found = std::binary_search(popped.begin(), popped.end(), expected);
-                check(found, "TreiberStack missing element in multi-thread test");
+        std::cout << "[TreiberStack] Multi-thread push test passed.\n\n";
+    }
+
+    // ---------- Hazard-pointer stack test ----------
+    {
+        std::cout << "[HPTreiberStack] Multi-thread push/pop (hazard pointers)...\n";
+        const int threads = 4;
+        const int per_thread = 20000;
+        const int total_pushes = threads * per_thread;
+
+        HPTreiberStack<int> st;
+        std::vector<Padded<std::size_t>> pops(threads);
+
+        // Interleaved pops keep nodes retiring while other threads
+        // hold hazards on them, so the reclamation scan runs hot
+        // instead of only on the final drain.
+        auto worker = [&](int id) {
+            int         x;
+            std::size_t got = 0;
+            for (int i = 0; i < per_thread; ++i) {
+                st.push(id * per_thread + i);
+                if ((i & 1) && st.pop(x))
+                    ++got;
             }
+            pops[id].v.store(got, std::memory_order_relaxed);
+        };
+
+        std::vector<std::jthread> ts;
+        ts.reserve(threads);
+        for (int t = 0; t < threads; ++t)
+            ts.emplace_back(worker, t);
+        for (auto& th : ts)
+            th.join();
+
+        std::size_t popped = 0;
+        for (int t = 0; t < threads; ++t)
+            popped += pops[t].v.load(std::memory_order_relaxed);
+
+        int x;
+        std::size_t drained = 0;
+        while (st.pop(x)) {
+            check(x >= 0 && x < total_pushes,
+                  "HPTreiberStack value out of range");
+            ++drained;
         }
 
-        std::cout << "[TreiberStack] Multi-thread push test passed.\n\n";
+        std::cout << "  pushed total:  " << total_pushes << "\n";
+        std::cout << "  popped+drained: " << (popped + drained) << "\n";
+        check((int)(popped + drained) == total_pushes,
+              "HPTreiberStack count match");
+
+        std::cout << "[HPTreiberStack] Hazard-pointer test passed.\n\n";
     }
 
     std::cout << "===== test_treiber OK =====\n";